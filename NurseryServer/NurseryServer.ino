@@ -1,10 +1,13 @@
 
+#include "automation_rules.h"
 #include "funhouse_screen.h"
 #include "led_ring.h"
 #include "led_strip_controller.h"
+#include "network_bringup.h"
 #include "nursery_monitor.h"
 #include "nursery_web_server.h"
-#include <ESPmDNS.h>
+#include "persistent_state.h"
+#include "state_broadcaster.h"
 #include <LittleFS.h>
 #include <WiFi.h>
 #include <WiFiClient.h>
@@ -17,18 +20,34 @@ const char* ssid = SECRET_SSID;
 const char* password = SECRET_PASS;
 /*---------------------------------------------------------------------------*/
 
+// Define as 1 to raise the level the strips turn on at in a bright room
+#ifndef AMBIENT_ADAPTS_STRIP
+    #define AMBIENT_ADAPTS_STRIP 0
+#endif
+
+// Define as 1 to multicast state frames for multi-room dashboards
+#ifndef STATE_BROADCAST
+    #define STATE_BROADCAST 0
+#endif
+
+/*---------------------------------------------------------------------------*/
+
 LEDStripController strip_controller(A0, A1);
 LEDRing led_ring;
-NurseryMonitor monitor(strip_controller, led_ring);
-NurseryWebServer web_server(strip_controller, led_ring, LittleFS, monitor);
+AutomationRules rules(strip_controller, led_ring);
+NurseryMonitor monitor(strip_controller, led_ring, rules);
 FunHouseScreen screen;
+PersistentState state(strip_controller, led_ring);
+NetworkBringup network(screen, state, ssid, password, "nursery");
+NurseryWebServer web_server(strip_controller, led_ring, LittleFS, monitor, rules, state, network);
+#if STATE_BROADCAST
+StateBroadcaster broadcaster(strip_controller, led_ring, monitor, network);
+#endif
 
 const char* ntpServer = "pool.ntp.org";
 const long gmtOffset_sec = -6 * 3600;
 const int daylightOffset_sec = 3600;
 
-String hostname = "nursery";
-
 /*---------------------------------------------------------------------------*/
 
 void setup()
@@ -37,10 +56,17 @@ void setup()
 
     pinMode(LED_BUILTIN, OUTPUT);
 
-    monitor.init();
+    // Restore the lights first so a power blip is barely noticeable
     strip_controller.init();
-    screen.init();
     led_ring.init();
+    state.begin();
+    state.restore();
+
+    // Wi-Fi and mDNS finish from loop() while the rest of setup runs
+    network.begin();
+
+    monitor.init();
+    screen.init();
 
     monitor.check_door_sensor();
 
@@ -50,48 +76,11 @@ void setup()
         screen.print_row(FunHouseScreen::AHT, ST77XX_GREEN, "AHT20: OK!");
     }
 
-    screen.print_row(FunHouseScreen::WIFI, ST77XX_YELLOW, "WIFI: ");
-    WiFi.mode(WIFI_STA);
-    WiFi.begin(ssid, password);
-    int tries = 0;
-    while (WiFi.status() != WL_CONNECTED && tries < 30) {
-        const char* frames[4] = { "|", "/", "-", "\\" };
-        static int frame = 0;
-        String text = String("WIFI: ") + String(frames[frame++]);
-        screen.print_row(FunHouseScreen::WIFI, ST77XX_YELLOW, text);
-        if (frame > 3)
-            frame = 0;
-        ++tries;
-        delay(100);
+    if (!monitor.ambient_begin()) {
+        screen.print_row(FunHouseScreen::AMBIENT, ST77XX_RED, "Ambient light: FAIL!");
     }
-    if (WiFi.status() == WL_CONNECTED) {
-        String text = String("WIFI: ") + WiFi.localIP().toString();
-        screen.print_row(FunHouseScreen::WIFI, ST77XX_GREEN, text);
-    } else {
-        screen.print_row(FunHouseScreen::WIFI, ST77XX_RED, "WIFI: Failed!");
-    }
-
-    screen.print_row(FunHouseScreen::MDNS, ST77XX_YELLOW, "MDNS: ");
-    if (mdns_init()) {
-        screen.print_row(FunHouseScreen::MDNS, ST77XX_RED, "MDNS: Failed mdns_init");
-    } else {
-        esp_ip4_addr_t addr;
-        addr.addr = 0;
-        esp_err_t err = mdns_query_a(hostname.c_str(), 5000,  &addr);
-        if (err && err == ESP_ERR_NOT_FOUND) {
-            // Use default hostname since no one else answered
-        } else {
-            hostname += "-dev";
-        }
-        mdns_free();
 
-        if (MDNS.begin(hostname)) {
-            String text = String("MDNS: ") + String(hostname);
-            screen.print_row(FunHouseScreen::MDNS, ST77XX_GREEN, text);
-        } else {
-            screen.print_row(FunHouseScreen::MDNS, ST77XX_RED, "MDNS: Failed");
-        }
-    }
+    screen.print_row(FunHouseScreen::WIFI, ST77XX_YELLOW, "WIFI: ");
 
     screen.print_row(FunHouseScreen::NTP, ST77XX_YELLOW, "NTP: ");
     configTime(gmtOffset_sec, daylightOffset_sec, ntpServer);
@@ -105,7 +94,9 @@ void setup()
 
     screen.print_row(FunHouseScreen::LFS, ST77XX_YELLOW, "LFS: ");
     if(LittleFS.begin(false)) {
-        screen.print_row(FunHouseScreen::LFS, ST77XX_GREEN, "LFS: Mounted");
+        rules.load(LittleFS, AutomationRules::PATH);
+        String text = String("LFS: ") + String(rules.num_rules()) + " rules";
+        screen.print_row(FunHouseScreen::LFS, ST77XX_GREEN, text);
     } else {
         screen.print_row(FunHouseScreen::LFS, ST77XX_RED, "LFS: Failed");
     }
@@ -124,10 +115,12 @@ void loop()
 
     digitalWrite(LED_BUILTIN, now % 1024 < 512);
 
+    network.update(now);
     web_server.handleClient();
 
     monitor.check_for_motion();
     monitor.check_door_sensor();
+    monitor.check_ambient_light();
     if (monitor.check_for_button_input()) {
         if (!screen.backlight_on())
             screen.set_backlight(true);
@@ -135,7 +128,22 @@ void loop()
         screen.set_backlight(false);
     }
 
+    const AmbientLight& ambient = monitor.ambient_light();
+    if (ambient.have_level()) {
+        EVERY_N_MILLISECONDS(250) {
+            led_ring.set_brightness(ambient.scaled(10, 96));
+            screen.set_backlight_level(ambient.scaled(24, 255));
+#if AMBIENT_ADAPTS_STRIP
+            strip_controller.set_initial_brightness(ambient.scaled(10, 60));
+#endif
+        }
+    }
+
     monitor.update_outputs(now);
+    state.update(now);
+#if STATE_BROADCAST
+    broadcaster.update(now);
+#endif
 
     if (screen.backlight_on()) {
         EVERY_N_MILLISECONDS(500) {
@@ -156,9 +164,10 @@ void loop()
                 int(humidity.relative_humidity));
             screen.print_row(FunHouseScreen::AHT, ST77XX_GREEN, buf);
 
-            uint16_t analogread = analogRead(A3);
-            snprintf(buf, 48, "Ambient light: %d", analogread);
-            screen.print_row(FunHouseScreen::AMBIENT, ST77XX_GREEN, buf);
+            if (ambient.have_level()) {
+                snprintf(buf, 48, "Ambient light: %d", ambient.level());
+                screen.print_row(FunHouseScreen::AMBIENT, ST77XX_GREEN, buf);
+            }
 
             snprintf(buf, 48, "LED level: %d/%d ", strip_controller.brightness(), strip_controller.max_brightness());
             screen.print_row(FunHouseScreen::LED_STRIP_LEVEL, ST77XX_GREEN, buf);
@@ -0,0 +1,125 @@
+
+#ifndef ambient_light_h
+#define ambient_light_h
+
+#include <driver/adc.h>
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Samples the FunHouse light sensor continuously with the ADC's DMA
+ * controller. Conversions accumulate in the driver's buffer without CPU
+ * involvement; update() drains whatever is ready without blocking and folds
+ * each batch into an oversampled, low-pass filtered level.
+ */
+class AmbientLight {
+    static const uint32_t SAMPLE_FREQ_HZ = 2000;
+    static const uint32_t FRAME_SAMPLES = 64;
+    static const uint32_t FRAME_BYTES = FRAME_SAMPLES * SOC_ADC_DIGI_RESULT_BYTES;
+    static const int DATA_BITS = 11;   // Width of the ESP32-S2 TYPE2 result's data field
+    static const int OUTPUT_BITS = 10; // Matches the previous analogRead() scale
+    static const int FILTER_SHIFT = 3; // Each batch moves the level 1/8 of the way
+
+    bool _running = false;
+    uint8_t _channel = 0;
+    uint32_t _filtered = 0; // Level scaled up by 1 << FILTER_SHIFT
+    bool _have_level = false;
+
+public:
+    bool begin()
+    {
+        int8_t analog_channel = digitalPinToAnalogChannel(SENSOR_LIGHT);
+        if (analog_channel < SOC_ADC_MAX_CHANNEL_NUM)
+            return false; // Only ADC2 pins are handled below
+        _channel = analog_channel - SOC_ADC_MAX_CHANNEL_NUM;
+
+        adc_digi_init_config_t init_config = {
+            .max_store_buf_size = FRAME_BYTES * 4,
+            .conv_num_each_intr = FRAME_BYTES,
+            .adc1_chan_mask = 0,
+            .adc2_chan_mask = (uint32_t)BIT(_channel),
+        };
+        if (adc_digi_initialize(&init_config) != ESP_OK)
+            return false;
+
+        adc_digi_pattern_config_t pattern = {
+            .atten = ADC_ATTEN_DB_11,
+            .channel = _channel,
+            .unit = 1, // ADC2
+            .bit_width = SOC_ADC_DIGI_MAX_BITWIDTH,
+        };
+        adc_digi_configuration_t config = {
+            .conv_limit_en = false,
+            .conv_limit_num = 0,
+            .pattern_num = 1,
+            .adc_pattern = &pattern,
+            .sample_freq_hz = SAMPLE_FREQ_HZ,
+            .conv_mode = ADC_CONV_SINGLE_UNIT_2,
+            .format = ADC_DIGI_OUTPUT_FORMAT_TYPE2,
+        };
+        if (adc_digi_controller_configure(&config) != ESP_OK || adc_digi_start() != ESP_OK) {
+            adc_digi_deinitialize();
+            return false;
+        }
+
+        _running = true;
+        return true;
+    }
+
+    bool running() const { return _running; }
+    bool have_level() const { return _have_level; }
+
+    /**
+     * Filtered light level from 0 (dark) to 1023 (bright).
+     */
+    uint16_t level() const { return _filtered >> FILTER_SHIFT; }
+
+    /**
+     * Maps the current level onto [dark, bright] along a square-root curve,
+     * which tracks perceived brightness better than a linear ramp.
+     */
+    uint8_t scaled(uint8_t dark, uint8_t bright) const
+    {
+        // sqrt(x / 1023) sampled at x = 0, 128, ..., 1024 in 1/256ths
+        static const uint16_t SQRT_CURVE[9] = { 0, 91, 128, 157, 181, 202, 222, 239, 256 };
+        uint16_t x = level();
+        uint16_t i = x >> 7;
+        uint16_t frac = x & 0x7F;
+        uint32_t y = SQRT_CURVE[i] + (((SQRT_CURVE[i + 1] - SQRT_CURVE[i]) * frac) >> 7);
+        return dark + (((int32_t)bright - dark) * (int32_t)y >> 8);
+    }
+
+    void update()
+    {
+        if (!_running)
+            return;
+
+        uint8_t buf[FRAME_BYTES];
+        uint32_t len = 0;
+        while (adc_digi_read_bytes(buf, sizeof(buf), &len, 0) == ESP_OK && len) {
+            uint32_t sum = 0;
+            uint32_t count = 0;
+            for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= len; i += SOC_ADC_DIGI_RESULT_BYTES) {
+                adc_digi_output_data_t* p = (adc_digi_output_data_t*)&buf[i];
+                if (p->type2.unit != 1 || p->type2.channel != _channel)
+                    continue; // Conversion lost to Wi-Fi arbitration or another channel
+                sum += p->type2.data;
+                ++count;
+            }
+            if (!count)
+                continue;
+
+            uint32_t batch = (sum / count) >> (DATA_BITS - OUTPUT_BITS);
+            if (!_have_level) {
+                _filtered = batch << FILTER_SHIFT;
+                _have_level = true;
+            } else {
+                _filtered += batch - (_filtered >> FILTER_SHIFT);
+            }
+        }
+    }
+};
+
+/*---------------------------------------------------------------------------*/
+
+#endif
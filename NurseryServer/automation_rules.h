@@ -0,0 +1,326 @@
+
+#ifndef automation_rules_h
+#define automation_rules_h
+
+#include "led_ring.h"
+#include "led_strip_controller.h"
+#include <ArduinoJson.h>
+#include <FS.h>
+#include <time.h>
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Runs time-of-day schedules and sensor triggered rules loaded from a JSON
+ * file. Rules are compiled into a table grouped by trigger so that an input
+ * change only visits the rules that depend on that input.
+ *
+ * Example rules file:
+ *   [
+ *     { "on": "time", "at": "06:45", "do": "wake" },
+ *     { "on": "motion", "from": "22:00", "to": "06:00",
+ *       "do": "brightness", "value": 20, "for": 10 }
+ *   ]
+ */
+class AutomationRules {
+public:
+    enum Trigger : uint8_t {
+        TIME,
+        MOTION,
+        DOOR_OPENED,
+        DOOR_CLOSED,
+        NUM_TRIGGERS,
+    };
+
+    static constexpr const char* PATH = "/rules.json";
+
+    enum Action : uint8_t {
+        BRIGHTNESS,
+        WAKE,
+        OFF,
+        RING,
+    };
+
+private:
+    static const int MAX_RULES = 32;
+    static const uint16_t ANY_TIME = 0xFFFF;
+    static const uint32_t CLOCK_CHECK_MS = 1000;
+
+    struct Rule {
+        Trigger trigger;
+        Action action;
+        uint8_t value;        // Brightness level or LEDRing::Mode
+        uint8_t hold_minutes; // Brightness reverts after this long, 0 to keep
+        uint16_t start;       // Minute of day, or ANY_TIME
+        uint16_t end;         // Minute of day, exclusive
+    };
+
+public:
+    /**
+     * Compiled rules, grouped by trigger.
+     */
+    struct Table {
+        Rule rules[MAX_RULES];
+        uint8_t first[NUM_TRIGGERS + 1] = { 0 }; // Rules for trigger t are [first[t], first[t + 1])
+    };
+
+private:
+    LEDStripController& _strip_controller;
+    LEDRing& _led_ring;
+    Table _table;
+    int _minute_of_day = -1; // -1 until the clock is set
+    uint32_t _last_clock_check_ms = 0;
+
+    bool _hold_active = false;
+    uint32_t _hold_end_ms = 0;
+    int _hold_brightness = 0;
+    int _restore_brightness = 0;
+
+public:
+    AutomationRules(LEDStripController& strip_controller, LEDRing& led_ring)
+        : _strip_controller(strip_controller)
+        , _led_ring(led_ring)
+    { }
+
+    int num_rules() const { return _table.first[NUM_TRIGGERS]; }
+
+    /**
+     * Replaces the current rules with those in the file at path. Returns false
+     * and keeps the current rules if the file is missing or invalid.
+     */
+    bool load(fs::FS& fs, const char* path)
+    {
+        File file = fs.open(path, "r");
+        if (!file || file.isDirectory())
+            return false;
+
+        Table table;
+        String error;
+        bool ok = compile(file, table, error);
+        file.close();
+        if (ok)
+            install(table);
+        return ok;
+    }
+
+    /**
+     * Parses a JSON array of rules into table. Every entry must be a valid
+     * rule; otherwise returns false with a description of the first problem
+     * in error.
+     */
+    template <typename TInput>
+    static bool compile(TInput& input, Table& table, String& error)
+    {
+        DynamicJsonDocument doc(4096);
+        DeserializationError err = deserializeJson(doc, input);
+        if (err) {
+            error = String("Invalid JSON: ") + err.c_str();
+            return false;
+        }
+        if (!doc.is<JsonArray>()) {
+            error = "Rules must be a JSON array";
+            return false;
+        }
+        JsonArray array = doc.as<JsonArray>();
+        if (array.size() > size_t(MAX_RULES)) {
+            error = String("At most ") + String(MAX_RULES) + " rules are supported";
+            return false;
+        }
+
+        Rule parsed[MAX_RULES];
+        int count = 0;
+        for (JsonVariant entry : array) {
+            if (!entry.is<JsonObject>() || !parse_rule(entry.as<JsonObject>(), parsed[count])) {
+                error = String("Rule ") + String(count + 1) + " is not valid";
+                return false;
+            }
+            ++count;
+        }
+
+        // Counting sort by trigger so each trigger's rules are contiguous
+        uint8_t counts[NUM_TRIGGERS] = { 0 };
+        for (int i = 0; i < count; ++i)
+            ++counts[parsed[i].trigger];
+        table.first[0] = 0;
+        for (int t = 0; t < NUM_TRIGGERS; ++t)
+            table.first[t + 1] = table.first[t] + counts[t];
+        uint8_t next[NUM_TRIGGERS];
+        memcpy(next, table.first, sizeof(next));
+        for (int i = 0; i < count; ++i)
+            table.rules[next[parsed[i].trigger]++] = parsed[i];
+        return true;
+    }
+
+    /**
+     * Makes a compiled table the active rules.
+     */
+    void install(const Table& table)
+    {
+        _table = table;
+        _hold_active = false;
+    }
+
+    /**
+     * Runs the rules attached to an input that just changed.
+     */
+    void trigger(Trigger input)
+    {
+        for (int i = _table.first[input]; i < _table.first[input + 1]; ++i) {
+            const Rule& rule = _table.rules[i];
+            if (input == TIME ? rule.start == _minute_of_day : in_window(rule))
+                apply(rule);
+        }
+    }
+
+    /**
+     * Expires held brightness levels and raises the TIME trigger whenever the
+     * wall clock moves to a new minute.
+     */
+    void update(uint32_t tm)
+    {
+        if (_hold_active && int32_t(tm - _hold_end_ms) >= 0) {
+            _hold_active = false;
+            // Leave the lights alone if someone changed them during the hold
+            if (_strip_controller.brightness() == _hold_brightness)
+                _strip_controller.set_brightness(_restore_brightness);
+        }
+
+        if (tm - _last_clock_check_ms < CLOCK_CHECK_MS)
+            return;
+        _last_clock_check_ms = tm;
+
+        struct tm timeinfo;
+        if (!getLocalTime(&timeinfo, 0))
+            return;
+        int minute_of_day = timeinfo.tm_hour * 60 + timeinfo.tm_min;
+        if (minute_of_day != _minute_of_day) {
+            _minute_of_day = minute_of_day;
+            trigger(TIME);
+        }
+    }
+
+    void add_status(StaticJsonDocument<1024>& doc)
+    {
+        doc["rules"] = num_rules();
+    }
+
+private:
+    static bool parse_minute(const char* str, uint16_t& minute)
+    {
+        int hr, min;
+        if (!str || sscanf(str, "%d:%d", &hr, &min) != 2 || hr < 0 || hr > 23 || min < 0 || min > 59)
+            return false;
+        minute = hr * 60 + min;
+        return true;
+    }
+
+    static bool parse_byte(JsonVariantConst value, uint8_t& result)
+    {
+        if (!value.is<int>() || value.as<int>() < 0 || value.as<int>() > 255)
+            return false;
+        result = value.as<int>();
+        return true;
+    }
+
+    static bool parse_rule(JsonObject obj, Rule& rule)
+    {
+        const char* on = obj["on"] | "";
+        if (!strcmp(on, "time"))
+            rule.trigger = TIME;
+        else if (!strcmp(on, "motion"))
+            rule.trigger = MOTION;
+        else if (!strcmp(on, "door_opened"))
+            rule.trigger = DOOR_OPENED;
+        else if (!strcmp(on, "door_closed"))
+            rule.trigger = DOOR_CLOSED;
+        else
+            return false;
+
+        const char* action = obj["do"] | "";
+        rule.value = 0;
+        if (!strcmp(action, "brightness")) {
+            rule.action = BRIGHTNESS;
+            if (!parse_byte(obj["value"], rule.value))
+                return false;
+        } else if (!strcmp(action, "wake")) {
+            rule.action = WAKE;
+        } else if (!strcmp(action, "off")) {
+            rule.action = OFF;
+        } else if (!strcmp(action, "ring")) {
+            rule.action = RING;
+            const char* mode = obj["mode"] | "";
+            if (!strcmp(mode, "off"))
+                rule.value = LEDRing::OFF;
+            else if (!strcmp(mode, "pulse"))
+                rule.value = LEDRing::PULSE;
+            else if (!strcmp(mode, "confetti"))
+                rule.value = LEDRing::CONFETTI;
+            else if (!strcmp(mode, "candle"))
+                rule.value = LEDRing::CANDLE;
+            else if (!strcmp(mode, "timeout"))
+                rule.value = LEDRing::TIMEOUT;
+            else
+                return false;
+        } else {
+            return false;
+        }
+        rule.hold_minutes = 0;
+        if (obj.containsKey("for") && !parse_byte(obj["for"], rule.hold_minutes))
+            return false;
+
+        if (rule.trigger == TIME) {
+            rule.end = 0;
+            return parse_minute(obj["at"].as<const char*>(), rule.start);
+        }
+
+        rule.start = rule.end = ANY_TIME;
+        if (obj.containsKey("from") || obj.containsKey("to"))
+            return parse_minute(obj["from"].as<const char*>(), rule.start) && parse_minute(obj["to"].as<const char*>(), rule.end);
+        return true;
+    }
+
+    bool in_window(const Rule& rule) const
+    {
+        if (rule.start == ANY_TIME)
+            return true;
+        if (_minute_of_day < 0)
+            return false;
+        if (rule.start <= rule.end)
+            return _minute_of_day >= rule.start && _minute_of_day < rule.end;
+        // Window wraps past midnight
+        return _minute_of_day >= rule.start || _minute_of_day < rule.end;
+    }
+
+    void apply(const Rule& rule)
+    {
+        switch (rule.action) {
+        case BRIGHTNESS:
+            if (rule.hold_minutes) {
+                // Re-triggering during a hold extends it without losing the original level
+                if (!_hold_active)
+                    _restore_brightness = _strip_controller.brightness();
+                _hold_active = true;
+                _hold_end_ms = millis() + rule.hold_minutes * 60000UL;
+            }
+            _strip_controller.set_brightness(rule.value);
+            _hold_brightness = _strip_controller.brightness();
+            break;
+        case WAKE:
+            _hold_active = false;
+            _strip_controller.begin_wake();
+            break;
+        case OFF:
+            _hold_active = false;
+            _strip_controller.turn_off();
+            _led_ring.setMode(LEDRing::OFF);
+            break;
+        case RING:
+            _led_ring.setMode(LEDRing::Mode(rule.value));
+            break;
+        }
+    }
+};
+
+/*---------------------------------------------------------------------------*/
+
+#endif
@@ -12,7 +12,10 @@
 class FunHouseScreen {
     Adafruit_ST7789 _tft = Adafruit_ST7789(TFT_CS, TFT_DC, TFT_RESET);
     bool _backlight_on = true;
+    uint8_t _backlight_level = 255;
 
+    static const int BACKLIGHT_CHANNEL = 2; // LEDC channels 0 and 1 drive the LED strips
+    static const int BACKLIGHT_HZ = 5000;
     static const int TEXT_SIZE = 2;
     static const int ROW_HEIGHT = 20; // For TextSize 2
     static const uint16_t BG_COLOR = ST77XX_BLACK;
@@ -34,8 +37,9 @@ public:
     void init()
     {
         _tft.init(240, 240);  // Initialize ST7789 screen
-        pinMode(TFT_BACKLIGHT, OUTPUT);
-        digitalWrite(TFT_BACKLIGHT, HIGH);  // Backlight on
+        ledcAttachPin(TFT_BACKLIGHT, BACKLIGHT_CHANNEL);
+        ledcSetup(BACKLIGHT_CHANNEL, BACKLIGHT_HZ, 8);
+        ledcWrite(BACKLIGHT_CHANNEL, _backlight_level);  // Backlight on
 
         _tft.fillScreen(BG_COLOR);
         _tft.setTextSize(TEXT_SIZE);
@@ -48,7 +52,16 @@ public:
     void set_backlight(bool state)
     {
         _backlight_on = state;
-        digitalWrite(TFT_BACKLIGHT, _backlight_on);
+        ledcWrite(BACKLIGHT_CHANNEL, _backlight_on ? _backlight_level : 0);
+    }
+
+    void set_backlight_level(uint8_t level)
+    {
+        if (level == _backlight_level)
+            return;
+        _backlight_level = level;
+        if (_backlight_on)
+            ledcWrite(BACKLIGHT_CHANNEL, _backlight_level);
     }
 
     void print_row(Row row, uint16_t color, String text)
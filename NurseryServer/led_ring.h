@@ -31,7 +31,7 @@ public:
 
 private:
     static const int NUM_LEDS = 36;
-    static const int BRIGHTNESS = 40;
+    static const int DEFAULT_BRIGHTNESS = 40;
     static const int FRAMES_PER_SECOND = 120;
     static const uint32_t TIMEOUT_DURATION = 180000;
 
@@ -51,9 +51,11 @@ public:
     void init()
     {
         FastLED.addLeds<WS2811, LED_RING_PIN, GRB>(_leds_with_dummy, NUM_LEDS + 1).setCorrection(TypicalLEDStrip);
-        FastLED.setBrightness(BRIGHTNESS);
+        FastLED.setBrightness(DEFAULT_BRIGHTNESS);
     }
 
+    void set_brightness(uint8_t brightness) { FastLED.setBrightness(brightness); }
+
     Mode mode() const { return _mode; }
 
     void setMode(Mode mode)
@@ -78,6 +80,19 @@ public:
         FastLED.show();
     }
 
+    /**
+     * Enters TIMEOUT mode part way through, e.g. after a restart.
+     */
+    void resume_timeout(uint32_t remaining_ms)
+    {
+        if (remaining_ms > TIMEOUT_DURATION)
+            remaining_ms = TIMEOUT_DURATION;
+        _timeout_start_ms = millis() - (TIMEOUT_DURATION - remaining_ms);
+        _mode = LEDRing::TIMEOUT;
+    }
+
+    uint32_t timeout_start_ms() const { return _timeout_start_ms; }
+
     bool in_timeout(uint32_t tm) const
     {
         return _mode == LEDRing::TIMEOUT && tm < _timeout_start_ms + TIMEOUT_DURATION;
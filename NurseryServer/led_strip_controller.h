@@ -22,6 +22,7 @@ class LEDStripController {
     bool _waking_up = false;
     uint32_t _wakeup_start_tm = 0;
     int _brightness = 0;
+    int _initial_brightness = INITIAL_BRIGHTNESS;
     struct tm _last_light_change_timeinfo;
     uint32_t _last_light_change_ms = 0;
 
@@ -32,6 +33,7 @@ public:
 
     bool lights_off() const { return _brightness == 0; }
     int brightness() const { return _brightness; }
+    bool waking_up() const { return _waking_up; }
     int max_brightness() const { return MAX_BRIGHTNESS; }
 
     void init()
@@ -63,7 +65,7 @@ public:
     void increase_brightness()
     {
         if (!_brightness)
-            _brightness = INITIAL_BRIGHTNESS;
+            _brightness = _initial_brightness;
         else
             _brightness += BRIGHTNESS_STEP;
 
@@ -84,6 +86,23 @@ public:
         _last_light_change_ms = millis();
     }
 
+    /**
+     * Sets the level the lights come on at when increased from off.
+     */
+    void set_initial_brightness(int brightness)
+    {
+        _initial_brightness = constrain(brightness, 1, MAX_BRIGHTNESS);
+    }
+
+    void set_brightness(int brightness)
+    {
+        _brightness = constrain(brightness, 0, MAX_BRIGHTNESS);
+        _waking_up = false;
+        // Don't wait for NTP: this runs during boot restore before it is configured
+        getLocalTime(&_last_light_change_timeinfo, 0);
+        _last_light_change_ms = millis();
+    }
+
     void begin_wake()
     {
         _waking_up = true;
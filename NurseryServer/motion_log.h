@@ -0,0 +1,198 @@
+
+#ifndef motion_log_h
+#define motion_log_h
+
+#include <ArduinoJson.h>
+#include <atomic>
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Captures PIR sensor edges from a GPIO interrupt so that motion is timed
+ * accurately however long loop() stalls. The interrupt stamps each edge and
+ * pushes it onto a single-producer, single-consumer ring; next() pops edges
+ * in the loop and folds each into the occupancy metrics in constant time:
+ *  - motion bursts over the last hour, in one-minute buckets, where edges
+ *    less than ACTIVITY_GAP_MS apart form one burst
+ *  - longest still period over the last night, in one-hour buckets
+ *  - time since the last sustained activity, a burst that has lasted
+ *    SUSTAINED_MS
+ */
+class MotionLog {
+public:
+    struct Edge {
+        uint32_t ms;
+        bool rising;
+    };
+
+private:
+    static const uint32_t RING_SIZE = 32; // Power of two
+    static const uint32_t BURST_MINUTES = 60;
+    static const uint32_t STILL_HOURS = 12;
+    static const uint32_t ACTIVITY_GAP_MS = 30000;
+    static const uint32_t SUSTAINED_MS = 60000;
+
+    /**
+     * Values kept per time bucket over a sliding window of N buckets.
+     */
+    template <uint32_t N, uint32_t BUCKET_MS>
+    struct Window {
+        uint32_t values[N] = { 0 };
+        uint32_t newest = 0;          // Slot of the newest bucket
+        uint32_t newest_start_ms = 0; // When the newest bucket began
+
+        /**
+         * Bucket for an event at ms. Edges stamped before the newest bucket
+         * began, e.g. drained after a status request moved the window on,
+         * count in the newest bucket rather than moving the window back.
+         */
+        uint32_t& at(uint32_t ms)
+        {
+            advance(ms);
+            return values[newest];
+        }
+
+        /**
+         * Moves the window on to cover ms. Times are compared as differences
+         * so that the window carries on across the millis() wrap.
+         */
+        void advance(uint32_t ms)
+        {
+            int32_t elapsed = int32_t(ms - newest_start_ms);
+            if (elapsed < int32_t(BUCKET_MS))
+                return;
+            uint32_t steps = elapsed / BUCKET_MS;
+            for (uint32_t i = 0; i < steps && i < N; ++i) {
+                newest = (newest + 1) % N;
+                values[newest] = 0;
+            }
+            newest_start_ms += steps * BUCKET_MS;
+        }
+
+        uint32_t total() const
+        {
+            uint32_t sum = 0;
+            for (uint32_t value : values)
+                sum += value;
+            return sum;
+        }
+
+        uint32_t largest() const
+        {
+            uint32_t result = 0;
+            for (uint32_t value : values)
+                result = value > result ? value : result;
+            return result;
+        }
+    };
+
+    // The interrupt handler writes ring slots, _head and _dropped; the loop
+    // writes only _tail. Acquire/release on the indices orders the slot
+    // accesses without disabling interrupts.
+    Edge _ring[RING_SIZE];
+    std::atomic<uint32_t> _head { 0 };
+    std::atomic<uint32_t> _tail { 0 };
+    std::atomic<uint32_t> _dropped { 0 };
+
+    uint8_t _pin = 0;
+    bool _high = false;
+    uint32_t _last_fall_ms = 0;
+    uint32_t _run_start_ms = 0;
+    uint32_t _last_sustained_ms = 0;
+    bool _have_sustained = false;
+    Window<BURST_MINUTES, 60000> _bursts;
+    Window<STILL_HOURS, 3600000> _still_secs;
+
+public:
+    void begin(uint8_t pin)
+    {
+        _pin = pin;
+        _high = digitalRead(pin);
+        _last_fall_ms = _run_start_ms = millis();
+        attachInterruptArg(pin, on_edge, this, CHANGE);
+    }
+
+    /**
+     * Pops the oldest captured edge, if any, and updates the metrics.
+     * Repeated levels, from edges lost to a full ring, are skipped. Once the
+     * ring is empty the windows are moved on to the current time, so they
+     * keep up across the millis() wrap even when nothing moves.
+     */
+    bool next(Edge& edge)
+    {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        uint32_t head = _head.load(std::memory_order_acquire);
+        while (tail != head) {
+            edge = _ring[tail++ % RING_SIZE];
+            _tail.store(tail, std::memory_order_release);
+            if (edge.rising != _high) {
+                record(edge);
+                return true;
+            }
+        }
+        uint32_t now = millis();
+        _bursts.advance(now);
+        _still_secs.advance(now);
+        return false;
+    }
+
+    bool high() const { return _high; }
+
+    void add_status(StaticJsonDocument<1024>& doc)
+    {
+        uint32_t now = millis();
+        _bursts.advance(now);
+        _still_secs.advance(now);
+
+        uint32_t longest = _still_secs.largest();
+        if (!_high && (now - _last_fall_ms) / 1000 > longest)
+            longest = (now - _last_fall_ms) / 1000;
+
+        doc["motion_bursts_hour"] = _bursts.total();
+        doc["longest_still_secs"] = longest;
+        if (_high && now - _run_start_ms >= SUSTAINED_MS)
+            doc["since_activity_secs"] = 0;
+        else if (_have_sustained)
+            doc["since_activity_secs"] = (now - _last_sustained_ms) / 1000;
+        if (uint32_t dropped = _dropped.load(std::memory_order_relaxed))
+            doc["motion_edges_dropped"] = dropped;
+    }
+
+private:
+    static void IRAM_ATTR on_edge(void* arg)
+    {
+        MotionLog* log = (MotionLog*)arg;
+        uint32_t head = log->_head.load(std::memory_order_relaxed);
+        if (head - log->_tail.load(std::memory_order_acquire) >= RING_SIZE) {
+            log->_dropped.store(log->_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return;
+        }
+        log->_ring[head % RING_SIZE] = { millis(), digitalRead(log->_pin) == HIGH };
+        log->_head.store(head + 1, std::memory_order_release);
+    }
+
+    void record(const Edge& edge)
+    {
+        _high = edge.rising;
+        if (edge.rising) {
+            uint32_t& still = _still_secs.at(edge.ms);
+            uint32_t secs = (edge.ms - _last_fall_ms) / 1000;
+            still = secs > still ? secs : still;
+            if (edge.ms - _last_fall_ms > ACTIVITY_GAP_MS) {
+                ++_bursts.at(edge.ms);
+                _run_start_ms = edge.ms;
+            }
+        } else {
+            _last_fall_ms = edge.ms;
+        }
+
+        if (edge.ms - _run_start_ms >= SUSTAINED_MS) {
+            _last_sustained_ms = edge.ms;
+            _have_sustained = true;
+        }
+    }
+};
+
+/*---------------------------------------------------------------------------*/
+
+#endif
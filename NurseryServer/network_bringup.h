@@ -0,0 +1,205 @@
+
+#ifndef network_bringup_h
+#define network_bringup_h
+
+#include "funhouse_screen.h"
+#include "persistent_state.h"
+#include <ArduinoJson.h>
+#include <ESPmDNS.h>
+#include <WiFi.h>
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Brings up Wi-Fi and mDNS without blocking setup(). The first attempt reuses
+ * the BSSID, channel and address from the last good connection, which skips
+ * the scan and DHCP. The cached address is kept through boot, then the
+ * interface goes back to DHCP so the lease is renewed, and whatever address
+ * DHCP assigns is cached for the next boot. The mDNS hostname clash check runs on its own task so its
+ * multi-second query does not hold up the LEDs or the web server.
+ */
+class NetworkBringup {
+    enum Phase {
+        CACHED,     // Joining with the cached BSSID, channel and address
+        SCANNING,   // Full scan and DHCP
+        WAITING,    // Gave up reporting progress, still auto-reconnecting
+        CONNECTED,
+    };
+
+    static const uint32_t CACHED_CONNECT_MS = 2000;
+    static const uint32_t CONNECT_MS = 10000;
+    static const uint32_t MDNS_QUERY_MS = 5000;
+    // Switching to DHCP clears the address until a lease arrives, so wait
+    // until boot is long finished
+    static const uint32_t DHCP_HANDOFF_MS = 60000;
+
+    FunHouseScreen& _screen;
+    PersistentState& _state;
+    const char* _ssid;
+    const char* _password;
+    String _hostname;
+    String _mdns_hostname; // Owned by the mDNS task until _mdns_done
+    Phase _phase = SCANNING;
+    uint32_t _phase_start_ms = 0;
+    uint32_t _http_ready_ms = 0;
+    bool _dhcp_handoff_due = false; // Joined with the cached address
+    bool _lease_pending = false;    // Handed off, waiting for the lease
+    volatile bool _got_lease = false; // Set from the Wi-Fi event task
+    volatile bool _mdns_done = false;
+    bool _mdns_ok = false;
+    bool _mdns_reported = false;
+
+public:
+    NetworkBringup(FunHouseScreen& screen, PersistentState& state, const char* ssid, const char* password, const char* hostname)
+        : _screen(screen)
+        , _state(state)
+        , _ssid(ssid)
+        , _password(password)
+        , _hostname(hostname)
+    { }
+
+    const String& hostname() const { return _hostname; }
+
+    void begin()
+    {
+        WiFi.mode(WIFI_STA);
+        WiFi.onEvent([this](arduino_event_id_t, arduino_event_info_t) {
+            if (_lease_pending)
+                _got_lease = true;
+        }, ARDUINO_EVENT_WIFI_STA_GOT_IP);
+
+        PersistentState::WiFiCache cache;
+        if (_state.load_wifi_cache(cache)) {
+            WiFi.config(IPAddress(cache.ip), IPAddress(cache.gateway), IPAddress(cache.subnet), IPAddress(cache.dns));
+            WiFi.begin(_ssid, _password, cache.channel, cache.bssid);
+            _phase = CACHED;
+        } else {
+            WiFi.begin(_ssid, _password);
+            _phase = SCANNING;
+        }
+        _phase_start_ms = millis();
+    }
+
+    void update(uint32_t tm)
+    {
+        if (_phase == CONNECTED) {
+            if (_dhcp_handoff_due && tm - _http_ready_ms >= DHCP_HANDOFF_MS) {
+                _dhcp_handoff_due = false;
+                _got_lease = false;
+                _lease_pending = true;
+                WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+            }
+            if (_lease_pending && _got_lease) {
+                _lease_pending = false;
+                save_wifi_cache();
+            }
+            if (_mdns_done && !_mdns_reported) {
+                _mdns_reported = true;
+                _hostname = _mdns_hostname;
+                if (_mdns_ok) {
+                    String text = String("MDNS: ") + _hostname;
+                    _screen.print_row(FunHouseScreen::MDNS, ST77XX_GREEN, text);
+                } else {
+                    _screen.print_row(FunHouseScreen::MDNS, ST77XX_RED, "MDNS: Failed");
+                }
+            }
+            return;
+        }
+
+        if (WiFi.status() == WL_CONNECTED) {
+            on_connected(tm);
+        } else if (_phase == CACHED && tm - _phase_start_ms > CACHED_CONNECT_MS) {
+            // The access point or address has changed; fall back to a full scan with DHCP
+            _state.clear_wifi_cache();
+            WiFi.disconnect();
+            WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+            WiFi.begin(_ssid, _password);
+            _phase = SCANNING;
+            _phase_start_ms = tm;
+        } else if (_phase == SCANNING && tm - _phase_start_ms > CONNECT_MS) {
+            _screen.print_row(FunHouseScreen::WIFI, ST77XX_RED, "WIFI: Failed!");
+            _phase = WAITING;
+        } else if (_phase != WAITING) {
+            EVERY_N_MILLISECONDS(100) {
+                const char* frames[4] = { "|", "/", "-", "\\" };
+                static int frame = 0;
+                String text = String("WIFI: ") + String(frames[frame++]);
+                _screen.print_row(FunHouseScreen::WIFI, ST77XX_YELLOW, text);
+                if (frame > 3)
+                    frame = 0;
+            }
+        }
+    }
+
+    void add_status(StaticJsonDocument<1024>& doc)
+    {
+        doc["boot_http_ms"] = _http_ready_ms;
+    }
+
+private:
+    void on_connected(uint32_t tm)
+    {
+        bool joined_cached = _phase == CACHED;
+        _phase = CONNECTED;
+        _http_ready_ms = tm;
+
+        String text = String("WIFI: ") + WiFi.localIP().toString();
+        _screen.print_row(FunHouseScreen::WIFI, ST77XX_GREEN, text);
+
+        if (joined_cached) {
+            // The cached address is applied as a static config with no lease;
+            // hand the interface back to DHCP after DHCP_HANDOFF_MS
+            _dhcp_handoff_due = true;
+        } else {
+            save_wifi_cache();
+        }
+
+        _screen.print_row(FunHouseScreen::MDNS, ST77XX_YELLOW, "MDNS: ");
+        _mdns_hostname = _hostname;
+        if (xTaskCreate(mdns_task, "mdns_bringup", 4096, this, 1, nullptr) != pdPASS) {
+            _mdns_done = true;
+        }
+    }
+
+    void save_wifi_cache()
+    {
+        PersistentState::WiFiCache cache;
+        memcpy(cache.bssid, WiFi.BSSID(), sizeof(cache.bssid));
+        cache.channel = WiFi.channel();
+        cache.ip = WiFi.localIP();
+        cache.gateway = WiFi.gatewayIP();
+        cache.subnet = WiFi.subnetMask();
+        cache.dns = WiFi.dnsIP();
+        _state.save_wifi_cache(cache);
+    }
+
+    static void mdns_task(void* arg)
+    {
+        NetworkBringup* self = static_cast<NetworkBringup*>(arg);
+        self->start_mdns();
+        self->_mdns_done = true;
+        vTaskDelete(nullptr);
+    }
+
+    void start_mdns()
+    {
+        if (mdns_init())
+            return;
+
+        esp_ip4_addr_t addr;
+        addr.addr = 0;
+        esp_err_t err = mdns_query_a(_mdns_hostname.c_str(), MDNS_QUERY_MS, &addr);
+        if (err && err == ESP_ERR_NOT_FOUND) {
+            // Use default hostname since no one else answered
+        } else {
+            _mdns_hostname += "-dev";
+        }
+        mdns_free();
+
+        _mdns_ok = MDNS.begin(_mdns_hostname.c_str());
+    }
+};
+
+/*---------------------------------------------------------------------------*/
+
+#endif
@@ -2,8 +2,11 @@
 #ifndef nursery_monitor_h
 #define nursery_monitor_h
 
+#include "ambient_light.h"
+#include "automation_rules.h"
 #include "led_ring.h"
 #include "led_strip_controller.h"
+#include "motion_log.h"
 #include <Adafruit_AHTX0.h>
 #include <Adafruit_MCP23008.h>
 #include <ArduinoJson.h>
@@ -17,9 +20,11 @@
 class NurseryMonitor {
     LEDStripController& _strip_controller;
     LEDRing& _ring_controller;
+    AutomationRules& _rules;
     Adafruit_MCP23008 _mcp;
     Adafruit_AHTX0 _aht;
-    bool _pir_triggered = false;
+    AmbientLight _ambient;
+    MotionLog _motion;
     bool _mcp_found = false;
     uint32_t _last_direct_input_tm = 0;
     bool _door_closed = false;
@@ -34,9 +39,10 @@ class NurseryMonitor {
     static const uint8_t REMOTE_C = 7;
 
 public:
-    NurseryMonitor(LEDStripController& strip_controller, LEDRing& ring_controller)
+    NurseryMonitor(LEDStripController& strip_controller, LEDRing& ring_controller, AutomationRules& rules)
         : _strip_controller(strip_controller)
         , _ring_controller(ring_controller)
+        , _rules(rules)
     { }
 
     void init()
@@ -46,11 +52,15 @@ public:
         pinMode(BUTTON_UP, INPUT_PULLDOWN);
         pinMode(SENSOR_PIR, INPUT);
         pinMode(SENSOR_LIGHT, INPUT);
-        analogReadResolution(10);
+        _motion.begin(SENSOR_PIR);
     }
 
     bool aht_begin() { return _aht.begin(); }
 
+    bool ambient_begin() { return _ambient.begin(); }
+
+    const AmbientLight& ambient_light() const { return _ambient; }
+
     bool mcp_begin()
     {
         if (_mcp.begin()) {
@@ -86,10 +96,13 @@ public:
         getAHTEvent(humidity, temp);
         doc["humidity"] = int(humidity.relative_humidity);
         doc["temperature"] = int(temp.temperature * 9 / 5 + 32);
+        if (_ambient.have_level())
+            doc["ambient_light"] = _ambient.level();
 
         char motionstr[128];
         strftime(motionstr, 128, "%H:%M:%S", &_last_motion_timeinfo);
         doc["last_motion_time"] = motionstr;
+        _motion.add_status(doc);
 
         char doorstr[128];
         strftime(doorstr, 128, "%H:%M:%S", &_last_door_change_timeinfo);
@@ -111,22 +124,33 @@ public:
         }
     }
 
+    bool door_closed() const { return _door_closed; }
+
+    bool motion_detected() const { return _motion.high(); }
+
     void reset_direct_input_timeout() { _last_direct_input_tm = millis(); }
 
     bool direct_input_timeout_past() { return millis() - _last_direct_input_tm > 10000; }
 
     void check_for_motion()
     {
-        if (digitalRead(SENSOR_PIR)) {
-            _pir_triggered = true;
-        } else {
-            if (_pir_triggered) {
-                _pir_triggered = false;
-                getLocalTime(&_last_motion_timeinfo);
+        MotionLog::Edge edge;
+        while (_motion.next(edge)) {
+            if (edge.rising) {
+                _rules.trigger(AutomationRules::MOTION);
+            } else {
+                // Back-date to the edge rather than when the loop got to it
+                struct tm timeinfo;
+                if (getLocalTime(&timeinfo, 0)) {
+                    time_t t = mktime(&timeinfo) - (millis() - edge.ms) / 1000;
+                    localtime_r(&t, &_last_motion_timeinfo);
+                }
             }
         }
     }
 
+    void check_ambient_light() { _ambient.update(); }
+
     void check_door_sensor()
     {
         if (!_mcp_found) return;
@@ -171,6 +195,7 @@ public:
 
     void update_outputs(uint32_t tm)
     {
+        _rules.update(tm);
         update_ring(tm);
         _strip_controller.update();
     }
@@ -205,6 +230,7 @@ private:
     {
         _door_closed = !_door_closed;
         getLocalTime(&_last_door_change_timeinfo);
+        _rules.trigger(_door_closed ? AutomationRules::DOOR_CLOSED : AutomationRules::DOOR_OPENED);
     }
 };
 
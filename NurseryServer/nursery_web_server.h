@@ -2,8 +2,11 @@
 #ifndef nursery_web_server_h
 #define nursery_web_server_h
 
+#include "automation_rules.h"
 #include "led_strip_controller.h"
+#include "network_bringup.h"
 #include "nursery_monitor.h"
+#include "persistent_state.h"
 #include <FS.h>
 #include <WebServer.h>
 
@@ -17,20 +20,28 @@ class NurseryWebServer {
     LEDRing& _led_ring;
     fs::FS& _fs;
     NurseryMonitor& _monitor;
+    AutomationRules& _rules;
+    PersistentState& _state;
+    NetworkBringup& _network;
     WebServer _server;
 
 public:
-    NurseryWebServer(LEDStripController& strip_controller, LEDRing& led_ring, fs::FS& fs, NurseryMonitor& monitor)
+    NurseryWebServer(LEDStripController& strip_controller, LEDRing& led_ring, fs::FS& fs, NurseryMonitor& monitor, AutomationRules& rules,
+                     PersistentState& state, NetworkBringup& network)
         : _strip_controller(strip_controller)
         , _led_ring(led_ring)
         , _fs(fs)
         , _monitor(monitor)
+        , _rules(rules)
+        , _state(state)
+        , _network(network)
         , _server(80)
     {
         _server.on("/", [this]() { this->handle_root(); });
         _server.on("/brighter", [this]() { this->handle_brighter(); });
         _server.on("/dimmer", [this]() { this->handle_dimmer(); });
         _server.on("/off", [this]() { this->handle_off(); });
+        _server.on("/rules", [this]() { this->handle_rules(); });
         _server.on("/status", [this]() { this->handle_status(); });
         _server.on("/timeout", [this]() { this->handle_timeout(); });
         _server.on("/wake", [this]() { this->handle_wake(); });
@@ -72,6 +83,41 @@ private:
         _server.send(200, "text/plain", "OK");
     }
 
+    void handle_rules()
+    {
+        if (_server.method() == HTTP_POST) {
+            // Validate before touching the saved rules, then replace the file
+            // in one rename so a failed write cannot lose them either
+            String body = _server.arg("plain");
+            AutomationRules::Table table;
+            String error;
+            if (!AutomationRules::compile(body, table, error)) {
+                _server.send(400, "text/plain", error);
+                return;
+            }
+            const char* temp_path = "/rules.json.new";
+            File file = _fs.open(temp_path, "w");
+            bool written = file && file.print(body) == body.length();
+            if (file)
+                file.close();
+            if (!written || !_fs.rename(temp_path, AutomationRules::PATH)) {
+                _fs.remove(temp_path);
+                _server.send(500, "text/plain", "Could not write rules");
+                return;
+            }
+            _rules.install(table);
+            _server.send(200, "text/plain", String(_rules.num_rules()) + " rules loaded");
+        } else {
+            File file = _fs.open(AutomationRules::PATH, "r");
+            if (!file || file.isDirectory()) {
+                _server.send(200, "text/json", "[]");
+            } else {
+                _server.streamFile(file, "text/json");
+                file.close();
+            }
+        }
+    }
+
     void handle_timeout()
     {
         if (_led_ring.mode() != LEDRing::TIMEOUT)
@@ -104,6 +150,9 @@ private:
 
         _strip_controller.add_status(doc);
         _monitor.add_status(doc);
+        _rules.add_status(doc);
+        _state.add_status(doc);
+        _network.add_status(doc);
 
         String json;
         serializeJson(doc, json);
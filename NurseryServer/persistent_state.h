@@ -0,0 +1,179 @@
+
+#ifndef persistent_state_h
+#define persistent_state_h
+
+#include "led_ring.h"
+#include "led_strip_controller.h"
+#include <ArduinoJson.h>
+#include <Preferences.h>
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Keeps the light state and Wi-Fi connection details in NVS so a power blip
+ * can be recovered from without waiting on the network. Light changes are
+ * written only once they have settled, so a burst of button presses costs a
+ * single flash write.
+ */
+class PersistentState {
+public:
+    struct WiFiCache {
+        uint8_t bssid[6];
+        uint8_t channel;
+        uint32_t ip;
+        uint32_t gateway;
+        uint32_t subnet;
+        uint32_t dns;
+    };
+
+private:
+    static const uint32_t CHECK_MS = 1000;
+    static const uint32_t SETTLE_MS = 5000;
+    static const uint32_t TIMEOUT_SAVE_MS = 30000;
+
+    struct LightState {
+        int brightness;
+        uint8_t ring_mode;
+        uint32_t timeout_start_ms;
+        bool timing_out;
+
+        bool operator==(const LightState& other) const
+        {
+            return brightness == other.brightness
+                && ring_mode == other.ring_mode
+                && timeout_start_ms == other.timeout_start_ms
+                && timing_out == other.timing_out;
+        }
+    };
+
+    LEDStripController& _strip_controller;
+    LEDRing& _led_ring;
+    Preferences _prefs;
+    bool _open = false;
+    LightState _saved = { 0, LEDRing::OFF, 0, false };
+    LightState _pending = { 0, LEDRing::OFF, 0, false };
+    uint32_t _pending_since_ms = 0;
+    uint32_t _last_check_ms = 0;
+    uint32_t _timeout_saved_ms = 0;
+    uint32_t _lights_restored_ms = 0;
+    uint32_t _writes = 0;
+
+public:
+    PersistentState(LEDStripController& strip_controller, LEDRing& led_ring)
+        : _strip_controller(strip_controller)
+        , _led_ring(led_ring)
+    { }
+
+    bool begin()
+    {
+        _open = _prefs.begin("nursery", false);
+        return _open;
+    }
+
+    /**
+     * Applies the saved light state and pushes it to the outputs immediately.
+     */
+    void restore()
+    {
+        if (_open) {
+            _saved.brightness = _prefs.getInt("brightness", 0);
+            _saved.ring_mode = _prefs.getUChar("ring_mode", LEDRing::OFF);
+            uint32_t timeout_remaining = _prefs.getUInt("timeout_ms", 0);
+
+            if (_saved.brightness)
+                _strip_controller.set_brightness(_saved.brightness);
+            if (_saved.ring_mode == LEDRing::TIMEOUT) {
+                // Time spent powered off is unknown, so resume where the last write left off
+                if (timeout_remaining)
+                    _led_ring.resume_timeout(timeout_remaining);
+            } else if (_saved.ring_mode <= LEDRing::CANDLE) {
+                _led_ring.setMode(LEDRing::Mode(_saved.ring_mode));
+            }
+        }
+
+        _strip_controller.update();
+        _led_ring.update();
+        _lights_restored_ms = millis();
+
+        _saved = _pending = current(_lights_restored_ms);
+        _timeout_saved_ms = _lights_restored_ms;
+    }
+
+    /**
+     * Writes the light state once it has stopped changing for SETTLE_MS, and
+     * the time left on a running timeout every TIMEOUT_SAVE_MS.
+     */
+    void update(uint32_t tm)
+    {
+        if (!_open || tm - _last_check_ms < CHECK_MS)
+            return;
+        _last_check_ms = tm;
+
+        LightState state = current(tm);
+        if (!(state == _pending)) {
+            _pending = state;
+            _pending_since_ms = tm;
+        } else if (!(_pending == _saved) && tm - _pending_since_ms >= SETTLE_MS) {
+            save(tm);
+        } else if (_saved.timing_out && state.timing_out && tm - _timeout_saved_ms >= TIMEOUT_SAVE_MS) {
+            _prefs.putUInt("timeout_ms", _led_ring.timeout_millis_remaining(tm)), ++_writes;
+            _timeout_saved_ms = tm;
+        }
+    }
+
+    bool load_wifi_cache(WiFiCache& cache)
+    {
+        return _open && _prefs.getBytes("wifi", &cache, sizeof(cache)) == sizeof(cache);
+    }
+
+    void save_wifi_cache(const WiFiCache& cache)
+    {
+        if (!_open)
+            return;
+        WiFiCache saved;
+        if (load_wifi_cache(saved) && !memcmp(&saved, &cache, sizeof(cache)))
+            return;
+        _prefs.putBytes("wifi", &cache, sizeof(cache));
+        ++_writes;
+    }
+
+    void clear_wifi_cache()
+    {
+        if (_open)
+            _prefs.remove("wifi");
+    }
+
+    void add_status(StaticJsonDocument<1024>& doc)
+    {
+        doc["boot_lights_ms"] = _lights_restored_ms;
+        doc["nvs_writes"] = _writes;
+    }
+
+private:
+    LightState current(uint32_t tm) const
+    {
+        return {
+            _strip_controller.brightness(),
+            uint8_t(_led_ring.mode()),
+            _led_ring.mode() == LEDRing::TIMEOUT ? _led_ring.timeout_start_ms() : 0,
+            _led_ring.in_timeout(tm),
+        };
+    }
+
+    void save(uint32_t tm)
+    {
+        if (_pending.brightness != _saved.brightness)
+            _prefs.putInt("brightness", _pending.brightness), ++_writes;
+        if (_pending.ring_mode != _saved.ring_mode)
+            _prefs.putUChar("ring_mode", _pending.ring_mode), ++_writes;
+        if (_pending.timeout_start_ms != _saved.timeout_start_ms || _pending.timing_out != _saved.timing_out) {
+            _prefs.putUInt("timeout_ms", _led_ring.timeout_millis_remaining(tm)), ++_writes;
+            _timeout_saved_ms = tm;
+        }
+        _saved = _pending;
+    }
+};
+
+/*---------------------------------------------------------------------------*/
+
+#endif
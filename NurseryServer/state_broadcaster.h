@@ -0,0 +1,105 @@
+
+#ifndef state_broadcaster_h
+#define state_broadcaster_h
+
+#include "led_ring.h"
+#include "led_strip_controller.h"
+#include "network_bringup.h"
+#include "nursery_monitor.h"
+#include "state_frame.h"
+#include <WiFi.h>
+#include <WiFiUdp.h>
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Multicasts a StateFrame whenever the lights, ring, door or motion state
+ * changes, and as a heartbeat so listeners can tell a quiet unit from a
+ * missing one.
+ */
+class StateBroadcaster {
+    static const uint32_t HEARTBEAT_MS = 5000;
+    static const uint32_t MIN_INTERVAL_MS = 100;   // Caps the rate during bursts of changes
+    static const uint32_t CLIMATE_REFRESH_MS = 60000; // AHT reads block for tens of ms
+
+    LEDStripController& _strip_controller;
+    LEDRing& _led_ring;
+    NurseryMonitor& _monitor;
+    NetworkBringup& _network;
+    WiFiUDP _udp;
+    IPAddress _group;
+    StateFrame _frame;
+    uint32_t _last_send_ms = 0;
+    uint32_t _last_climate_ms = 0;
+    bool _have_climate = false;
+
+public:
+    StateBroadcaster(LEDStripController& strip_controller, LEDRing& led_ring, NurseryMonitor& monitor, NetworkBringup& network)
+        : _strip_controller(strip_controller)
+        , _led_ring(led_ring)
+        , _monitor(monitor)
+        , _network(network)
+    {
+        _group.fromString(StateFrame::GROUP);
+    }
+
+    void update(uint32_t tm)
+    {
+        if (WiFi.status() != WL_CONNECTED)
+            return;
+
+        if (!_have_climate || tm - _last_climate_ms > CLIMATE_REFRESH_MS) {
+            sensors_event_t humidity, temp;
+            _monitor.getAHTEvent(humidity, temp);
+            _frame.temperature_tenths_f = int16_t((temp.temperature * 9 / 5 + 32) * 10);
+            _frame.humidity = uint8_t(humidity.relative_humidity);
+            _last_climate_ms = tm;
+            _have_climate = true;
+        }
+
+        uint8_t flags = 0;
+        if (_monitor.door_closed())
+            flags |= StateFrame::FLAG_DOOR_CLOSED;
+        if (_monitor.motion_detected())
+            flags |= StateFrame::FLAG_MOTION;
+        if (_strip_controller.waking_up())
+            flags |= StateFrame::FLAG_WAKING;
+        uint8_t brightness = _strip_controller.brightness();
+        uint8_t ring_mode = _led_ring.mode();
+        bool timing_out = _led_ring.in_timeout(tm);
+
+        bool changed = flags != (_frame.flags & ~StateFrame::FLAG_HEARTBEAT)
+            || brightness != _frame.brightness
+            || ring_mode != _frame.ring_mode
+            || timing_out != (_frame.timeout_secs != 0);
+        uint32_t since_send = tm - _last_send_ms;
+        if (changed ? since_send < MIN_INTERVAL_MS : since_send < HEARTBEAT_MS)
+            return;
+
+        _frame.flags = flags | (changed ? 0 : StateFrame::FLAG_HEARTBEAT);
+        _frame.brightness = brightness;
+        _frame.ring_mode = ring_mode;
+        _frame.timeout_secs = (_led_ring.timeout_millis_remaining(tm) + 999) / 1000;
+        _frame.set_hostname(_network.hostname().c_str());
+        ++_frame.sequence;
+        send();
+        _last_send_ms = tm;
+    }
+
+private:
+    void send()
+    {
+        uint8_t buf[StateFrame::MAX_SIZE];
+        size_t len = _frame.encode(buf, sizeof(buf));
+        if (!len)
+            return;
+        if (_udp.beginPacket(_group, StateFrame::PORT)) {
+            _udp.write(buf, len);
+            _udp.endPacket();
+        }
+    }
+};
+
+/*---------------------------------------------------------------------------*/
+
+#endif
@@ -0,0 +1,129 @@
+
+#ifndef state_frame_h
+#define state_frame_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Compact binary snapshot of a unit's state, multicast so that one listener
+ * can follow several rooms. Has no Arduino dependencies so that host tools
+ * can share it.
+ *
+ * Layout, multi-byte fields little-endian:
+ *   0  magic "NS"
+ *   2  version
+ *   3  flags (FLAG_*)
+ *   4  sequence number, uint32
+ *   8  strip brightness
+ *   9  LEDRing::Mode
+ *  10  temperature in tenths of a degree F, int16
+ *  12  relative humidity %
+ *  13  reserved, zero
+ *  14  timeout seconds remaining, uint16
+ *  16  hostname length n
+ *  17  hostname, n bytes, not terminated
+ */
+struct StateFrame {
+    static const uint8_t MAGIC_0 = 'N';
+    static const uint8_t MAGIC_1 = 'S';
+    static const uint8_t VERSION = 1;
+    static const size_t HEADER_SIZE = 17;
+    static const size_t MAX_HOSTNAME = 31;
+    static const size_t MAX_SIZE = HEADER_SIZE + MAX_HOSTNAME;
+
+    static const uint16_t PORT = 47830;
+    static constexpr const char* GROUP = "239.255.78.83";
+
+    enum Flags : uint8_t {
+        FLAG_DOOR_CLOSED = 1 << 0,
+        FLAG_MOTION = 1 << 1,
+        FLAG_WAKING = 1 << 2,
+        FLAG_HEARTBEAT = 1 << 3, // Sent on the timer rather than for a change
+    };
+
+    uint8_t flags = 0;
+    uint32_t sequence = 0;
+    uint8_t brightness = 0;
+    uint8_t ring_mode = 0;
+    int16_t temperature_tenths_f = 0;
+    uint8_t humidity = 0;
+    uint16_t timeout_secs = 0;
+    char hostname[MAX_HOSTNAME + 1] = { 0 };
+
+    /**
+     * Returns the number of bytes written, or 0 if len is too small.
+     */
+    size_t encode(uint8_t* buf, size_t len) const
+    {
+        size_t n = strnlen(hostname, MAX_HOSTNAME);
+        if (len < HEADER_SIZE + n)
+            return 0;
+        buf[0] = MAGIC_0;
+        buf[1] = MAGIC_1;
+        buf[2] = VERSION;
+        buf[3] = flags;
+        put_u32(buf + 4, sequence);
+        buf[8] = brightness;
+        buf[9] = ring_mode;
+        put_u16(buf + 10, uint16_t(temperature_tenths_f));
+        buf[12] = humidity;
+        buf[13] = 0;
+        put_u16(buf + 14, timeout_secs);
+        buf[16] = uint8_t(n);
+        memcpy(buf + HEADER_SIZE, hostname, n);
+        return HEADER_SIZE + n;
+    }
+
+    /**
+     * Returns false for foreign packets, unknown versions and truncated frames.
+     */
+    bool decode(const uint8_t* buf, size_t len)
+    {
+        if (len < HEADER_SIZE || buf[0] != MAGIC_0 || buf[1] != MAGIC_1 || buf[2] != VERSION)
+            return false;
+        size_t n = buf[16];
+        if (n > MAX_HOSTNAME || len < HEADER_SIZE + n)
+            return false;
+        flags = buf[3];
+        sequence = get_u32(buf + 4);
+        brightness = buf[8];
+        ring_mode = buf[9];
+        temperature_tenths_f = int16_t(get_u16(buf + 10));
+        humidity = buf[12];
+        timeout_secs = get_u16(buf + 14);
+        memcpy(hostname, buf + HEADER_SIZE, n);
+        hostname[n] = 0;
+        return true;
+    }
+
+    void set_hostname(const char* name)
+    {
+        strncpy(hostname, name, MAX_HOSTNAME);
+        hostname[MAX_HOSTNAME] = 0;
+    }
+
+private:
+    static void put_u16(uint8_t* p, uint16_t v)
+    {
+        p[0] = v & 0xFF;
+        p[1] = v >> 8;
+    }
+
+    static void put_u32(uint8_t* p, uint32_t v)
+    {
+        put_u16(p, v & 0xFFFF);
+        put_u16(p + 2, v >> 16);
+    }
+
+    static uint16_t get_u16(const uint8_t* p) { return p[0] | (uint16_t(p[1]) << 8); }
+
+    static uint32_t get_u32(const uint8_t* p) { return get_u16(p) | (uint32_t(get_u16(p + 2)) << 16); }
+};
+
+/*---------------------------------------------------------------------------*/
+
+#endif
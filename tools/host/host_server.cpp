@@ -0,0 +1,255 @@
+
+/**
+ * Runs NurseryWebServer on a Linux host against the stand-ins in shim/, so
+ * that load and soak tests can be run without hardware. The main loop
+ * mirrors loop() in the sketch and reports, every --report seconds:
+ *  - requests served
+ *  - control loop period percentiles, where a long tail means HTTP handling
+ *    is delaying the LED updates
+ *  - heap in use and its high-water mark, counted on every allocation
+ *  - allocator arena size and free space within it, whose growth under a
+ *    steady load points at fragmentation
+ *
+ * The host allocator is not the ESP32 heap, so absolute numbers differ from
+ * the device; trends over a long run are what matter.
+ *
+ * Usage:
+ *   nursery_host_server [--port N] [--root DIR] [--report SECS]
+ *                       [--duration SECS] [--aht-ms MS] [--ntp-ms MS]
+ *                       [--brightness N]
+ *
+ * The wall clock stays unset until --ntp-ms after setup asks for NTP, so
+ * code that waits on it stalls as it does on a unit after power loss.
+ * --brightness seeds the saved light level to exercise the boot restore.
+ */
+
+// ArduinoJson should use the Arduino String and Stream stand-ins
+#define ARDUINOJSON_ENABLE_ARDUINO_STRING 1
+#define ARDUINOJSON_ENABLE_ARDUINO_STREAM 1
+#define ARDUINOJSON_ENABLE_ARDUINO_PRINT 0
+#define ARDUINOJSON_ENABLE_PROGMEM 0
+
+#include "../../NurseryServer/nursery_web_server.h"
+#include "../latency_histogram.h"
+#include <atomic>
+#include <csignal>
+#include <malloc.h>
+#include <new>
+
+/*---------------------------------------------------------------------------*/
+
+// Heap accounting. The build links with --wrap for the malloc family, so
+// every allocation made from this program, including those behind the
+// operator new replacements below, passes through these wrappers.
+
+namespace {
+
+std::atomic<int64_t> heap_in_use(0);
+std::atomic<int64_t> heap_high_water(0);
+
+void heap_add(void* p)
+{
+    int64_t in_use = heap_in_use += malloc_usable_size(p);
+    int64_t high = heap_high_water.load();
+    while (in_use > high && !heap_high_water.compare_exchange_weak(high, in_use))
+        ;
+}
+
+void heap_remove(void* p) { heap_in_use -= malloc_usable_size(p); }
+
+} // namespace
+
+extern "C" {
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* p, size_t size);
+void __real_free(void* p);
+
+void* __wrap_malloc(size_t size)
+{
+    void* p = __real_malloc(size);
+    if (p)
+        heap_add(p);
+    return p;
+}
+
+void* __wrap_calloc(size_t count, size_t size)
+{
+    void* p = __real_calloc(count, size);
+    if (p)
+        heap_add(p);
+    return p;
+}
+
+void* __wrap_realloc(void* p, size_t size)
+{
+    size_t old_size = p ? malloc_usable_size(p) : 0;
+    void* q = __real_realloc(p, size);
+    if (q || !size) {
+        heap_in_use -= old_size;
+        if (q)
+            heap_add(q);
+    }
+    return q;
+}
+
+void __wrap_free(void* p)
+{
+    if (p)
+        heap_remove(p);
+    __real_free(p);
+}
+
+} // extern "C"
+
+void* operator new(size_t size)
+{
+    void* p = malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+/*---------------------------------------------------------------------------*/
+
+namespace {
+
+volatile sig_atomic_t stop_requested = 0;
+
+struct Options {
+    int port = 8080;
+    const char* root = "NurseryServer/resources";
+    uint32_t report_secs = 10;
+    uint32_t duration_secs = 0;
+    int brightness = 0;
+};
+
+bool parse_args(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        bool has_value = i + 1 < argc;
+        if (!strcmp(argv[i], "--port") && has_value)
+            options.port = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--root") && has_value)
+            options.root = argv[++i];
+        else if (!strcmp(argv[i], "--report") && has_value)
+            options.report_secs = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--duration") && has_value)
+            options.duration_secs = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--aht-ms") && has_value)
+            Adafruit_AHTX0::read_delay_ms() = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--ntp-ms") && has_value)
+            ntp_delay_ms() = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--brightness") && has_value)
+            options.brightness = atoi(argv[++i]);
+        else
+            return false;
+    }
+    return true;
+}
+
+void report(uint32_t elapsed_ms, uint64_t requests, const LatencyHistogram& loop_period, const LatencyHistogram& total_period)
+{
+    struct mallinfo2 info = mallinfo2();
+    printf("t=%us requests=%llu loop_p50=%lluus loop_p99=%lluus loop_max=%lluus run_loop_max=%lluus"
+           " heap=%lldB heap_high=%lldB arena=%zuB arena_free=%zuB\n",
+        elapsed_ms / 1000, (unsigned long long)requests,
+        (unsigned long long)loop_period.percentile_us(50),
+        (unsigned long long)loop_period.percentile_us(99),
+        (unsigned long long)loop_period.max_us(),
+        (unsigned long long)total_period.max_us(),
+        (long long)heap_in_use.load(), (long long)heap_high_water.load(),
+        info.arena + info.hblkhd, info.fordblks);
+    fflush(stdout);
+}
+
+} // namespace
+
+/*---------------------------------------------------------------------------*/
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parse_args(argc, argv, options)) {
+        fprintf(stderr,
+            "usage: %s [--port N] [--root DIR] [--report SECS] [--duration SECS]\n"
+            "          [--aht-ms MS] [--ntp-ms MS] [--brightness N]\n",
+            argv[0]);
+        return 2;
+    }
+    signal(SIGINT, [](int) { stop_requested = 1; });
+    signal(SIGTERM, [](int) { stop_requested = 1; });
+
+    WebServer::port_override() = options.port;
+    fs::FS fs(options.root);
+
+    LEDStripController strip_controller(A0, A1);
+    LEDRing led_ring;
+    AutomationRules rules(strip_controller, led_ring);
+    NurseryMonitor monitor(strip_controller, led_ring, rules);
+    FunHouseScreen screen;
+    PersistentState state(strip_controller, led_ring);
+    NetworkBringup network(screen, state, "host", "host", "nursery");
+    NurseryWebServer web_server(strip_controller, led_ring, fs, monitor, rules, state, network);
+
+    if (options.brightness) {
+        Preferences prefs;
+        prefs.begin("nursery");
+        prefs.putInt("brightness", options.brightness);
+    }
+
+    strip_controller.init();
+    led_ring.init();
+    state.begin();
+    state.restore();
+    network.begin();
+    monitor.init();
+    monitor.aht_begin();
+    configTime(0, 0, "pool.ntp.org");
+    rules.load(fs, AutomationRules::PATH);
+    web_server.begin();
+    printf("Serving %s on port %d\n", options.root, options.port);
+
+    LatencyHistogram loop_period;
+    LatencyHistogram total_period;
+    uint32_t start_ms = millis();
+    uint32_t last_report_ms = start_ms;
+    uint32_t last_loop_us = micros();
+
+    while (!stop_requested) {
+        uint32_t now = millis();
+        if (options.duration_secs && now - start_ms >= options.duration_secs * 1000)
+            break;
+
+        network.update(now);
+        web_server.handleClient();
+        monitor.check_for_motion();
+        monitor.check_door_sensor();
+        monitor.check_for_button_input();
+        monitor.update_outputs(now);
+        state.update(now);
+
+        if (now - last_report_ms >= options.report_secs * 1000) {
+            report(now - start_ms, WebServer::request_count(), loop_period, total_period);
+            loop_period.reset();
+            last_report_ms = now;
+        }
+
+        delay(1);
+
+        uint32_t loop_us = micros();
+        loop_period.add(loop_us - last_loop_us);
+        total_period.add(loop_us - last_loop_us);
+        last_loop_us = loop_us;
+    }
+
+    report(millis() - start_ms, WebServer::request_count(), total_period, total_period);
+    return 0;
+}
@@ -0,0 +1,37 @@
+
+#ifndef host_shim_adafruit_ahtx0_h
+#define host_shim_adafruit_ahtx0_h
+
+/**
+ * Host stand-in for the AHT20 driver. Readings are fixed, but each one
+ * blocks for read_delay_ms to match the time the real sensor takes to
+ * convert.
+ */
+
+#include "Arduino.h"
+
+typedef struct {
+    float temperature;
+    float relative_humidity;
+} sensors_event_t;
+
+class Adafruit_AHTX0 {
+public:
+    static uint32_t& read_delay_ms()
+    {
+        static uint32_t ms = 80;
+        return ms;
+    }
+
+    bool begin() { return true; }
+
+    bool getEvent(sensors_event_t* humidity, sensors_event_t* temp)
+    {
+        delay(read_delay_ms());
+        humidity->relative_humidity = 45;
+        temp->temperature = 21.5;
+        return true;
+    }
+};
+
+#endif
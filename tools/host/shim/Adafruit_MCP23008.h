@@ -0,0 +1,19 @@
+
+#ifndef host_shim_adafruit_mcp23008_h
+#define host_shim_adafruit_mcp23008_h
+
+/**
+ * Host stand-in for the MCP23008 driver. The expander is never found.
+ */
+
+#include "Arduino.h"
+
+class Adafruit_MCP23008 {
+public:
+    bool begin() { return false; }
+    void pinMode(uint8_t, uint8_t) { }
+    void pullUp(uint8_t, uint8_t) { }
+    uint8_t digitalRead(uint8_t) { return LOW; }
+};
+
+#endif
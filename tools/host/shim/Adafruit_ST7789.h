@@ -0,0 +1,29 @@
+
+#ifndef host_shim_adafruit_st7789_h
+#define host_shim_adafruit_st7789_h
+
+/**
+ * Host stand-in for the ST7789 TFT driver. Drawing is discarded.
+ */
+
+#include "Arduino.h"
+
+#define ST77XX_BLACK 0x0000
+#define ST77XX_RED 0xF800
+#define ST77XX_GREEN 0x07E0
+#define ST77XX_YELLOW 0xFFE0
+
+class Adafruit_ST7789 {
+public:
+    Adafruit_ST7789(int8_t, int8_t, int8_t) { }
+    void init(uint16_t, uint16_t) { }
+    void fillScreen(uint16_t) { }
+    void setTextSize(uint8_t) { }
+    void setTextColor(uint16_t) { }
+    void setTextColor(uint16_t, uint16_t) { }
+    void setTextWrap(bool) { }
+    void setCursor(int16_t, int16_t) { }
+    size_t println(const String& text) { return text.length(); }
+};
+
+#endif
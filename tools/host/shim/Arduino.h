@@ -0,0 +1,303 @@
+
+#ifndef host_shim_arduino_h
+#define host_shim_arduino_h
+
+/**
+ * Host stand-in for the parts of the Arduino core used by the sketch
+ * headers. Time comes from the host's steady clock; GPIO and LEDC calls
+ * are no-ops.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <time.h>
+
+using std::max;
+using std::min;
+
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLDOWN 0x09
+#define CHANGE 0x03
+
+#define IRAM_ATTR
+
+#define BIT(n) (1UL << (n))
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// FunHouse variant pins
+#define A0 17
+#define A1 2
+#define A2 1
+#define A3 18
+#define LED_BUILTIN 37
+#define BUTTON_DOWN 3
+#define BUTTON_SELECT 4
+#define BUTTON_UP 5
+#define SENSOR_PIR 16
+#define SENSOR_LIGHT 18
+#define TFT_CS 40
+#define TFT_DC 39
+#define TFT_RESET 41
+#define TFT_BACKLIGHT 21
+
+/*---------------------------------------------------------------------------*/
+
+inline std::chrono::steady_clock::time_point host_start_time()
+{
+    static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    return start;
+}
+
+inline uint32_t millis()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - host_start_time()).count();
+}
+
+inline uint32_t micros()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - host_start_time()).count();
+}
+
+inline void delay(uint32_t ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+
+inline void pinMode(uint8_t, uint8_t) { }
+inline int digitalRead(uint8_t) { return LOW; }
+inline void digitalWrite(uint8_t, uint8_t) { }
+inline int8_t digitalPinToAnalogChannel(uint8_t) { return -1; }
+inline void attachInterruptArg(uint8_t, void (*)(void*), void*, int) { }
+
+inline void ledcAttachPin(uint8_t, uint8_t) { }
+inline double ledcSetup(uint8_t, double freq, uint8_t) { return freq; }
+inline void ledcWrite(uint8_t, uint32_t) { }
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_NOT_FOUND 0x105
+#define ESP_ERR_NOT_SUPPORTED 0x106
+
+// FreeRTOS tasks run as detached host threads
+typedef int BaseType_t;
+typedef void* TaskHandle_t;
+#define pdPASS 1
+
+inline BaseType_t xTaskCreate(void (*task)(void*), const char*, uint32_t, void* arg, int, TaskHandle_t*)
+{
+    std::thread(task, arg).detach();
+    return pdPASS;
+}
+
+inline void vTaskDelete(TaskHandle_t) { }
+
+// The wall clock starts unset, as on a unit after power loss, and is set
+// ntp_delay_ms() after configTime() to stand in for the first NTP reply.
+inline uint32_t& ntp_delay_ms()
+{
+    static uint32_t ms = 2000;
+    return ms;
+}
+
+inline int64_t& host_clock_set_ms()
+{
+    static int64_t ms = -1;
+    return ms;
+}
+
+inline void configTime(long, int, const char*)
+{
+    host_clock_set_ms() = int64_t(millis()) + ntp_delay_ms();
+}
+
+/**
+ * Polls like the ESP32 core: returns false after waiting up to ms if the
+ * clock has not been set.
+ */
+inline bool getLocalTime(struct tm* info, uint32_t ms = 5000)
+{
+    uint32_t start = millis();
+    while (host_clock_set_ms() < 0 || int64_t(millis()) < host_clock_set_ms()) {
+        if (millis() - start >= ms)
+            return false;
+        delay(10);
+    }
+    time_t now = time(nullptr);
+    localtime_r(&now, info);
+    return true;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Heap-backed string with the subset of the Arduino String API the sketch
+ * uses. Like the Arduino class it grows with realloc, so the host build
+ * exercises the same allocation pattern as the handlers on the device.
+ */
+class String {
+    char* _buf = nullptr;
+    size_t _len = 0;
+    size_t _cap = 0;
+
+public:
+    String(const char* str = "") { assign(str, strlen(str)); }
+    String(const String& other) { assign(other._buf, other._len); }
+    String(String&& other) noexcept
+        : _buf(other._buf)
+        , _len(other._len)
+        , _cap(other._cap)
+    {
+        other._buf = nullptr;
+        other._len = other._cap = 0;
+    }
+    explicit String(char c) { assign(&c, 1); }
+    explicit String(int value) { assign_number("%d", value); }
+    explicit String(unsigned int value) { assign_number("%u", value); }
+    explicit String(long value) { assign_number("%ld", value); }
+    explicit String(unsigned long value) { assign_number("%lu", value); }
+    ~String() { free(_buf); }
+
+    String& operator=(const String& other)
+    {
+        if (this != &other)
+            assign(other._buf, other._len);
+        return *this;
+    }
+    String& operator=(String&& other) noexcept
+    {
+        if (this != &other) {
+            free(_buf);
+            _buf = other._buf;
+            _len = other._len;
+            _cap = other._cap;
+            other._buf = nullptr;
+            other._len = other._cap = 0;
+        }
+        return *this;
+    }
+    String& operator=(const char* str) { return assign(str, strlen(str)); }
+
+    const char* c_str() const { return _buf ? _buf : ""; }
+    size_t length() const { return _len; }
+    bool reserve(size_t size) { return (_buf && size <= _cap) || grow(size); }
+
+    bool concat(const char* str, size_t n)
+    {
+        if (!reserve(_len + n))
+            return false;
+        memcpy(_buf + _len, str, n);
+        _len += n;
+        _buf[_len] = 0;
+        return true;
+    }
+    bool concat(const char* str) { return concat(str, strlen(str)); }
+    bool concat(const String& str) { return concat(str.c_str(), str._len); }
+    bool concat(char c) { return concat(&c, 1); }
+
+    String& operator+=(const String& str) { concat(str); return *this; }
+    String& operator+=(const char* str) { concat(str); return *this; }
+    String& operator+=(char c) { concat(c); return *this; }
+
+    bool operator==(const String& other) const { return _len == other._len && !memcmp(c_str(), other.c_str(), _len); }
+    bool operator==(const char* str) const { return !strcmp(c_str(), str); }
+    bool operator!=(const String& other) const { return !(*this == other); }
+    bool operator<(const String& other) const { return strcmp(c_str(), other.c_str()) < 0; }
+    char operator[](size_t i) const { return i < _len ? _buf[i] : 0; }
+
+    bool startsWith(const String& prefix) const { return prefix._len <= _len && !memcmp(c_str(), prefix.c_str(), prefix._len); }
+    bool endsWith(const String& suffix) const { return suffix._len <= _len && !memcmp(c_str() + _len - suffix._len, suffix.c_str(), suffix._len); }
+    int indexOf(char c, size_t from = 0) const
+    {
+        for (size_t i = from; i < _len; ++i)
+            if (_buf[i] == c)
+                return i;
+        return -1;
+    }
+
+    String substring(size_t from, size_t to) const
+    {
+        String result;
+        if (to > _len)
+            to = _len;
+        if (from < to)
+            result.assign(_buf + from, to - from);
+        return result;
+    }
+    String substring(size_t from) const { return substring(from, _len); }
+
+    long toInt() const { return atol(c_str()); }
+
+private:
+    bool grow(size_t size)
+    {
+        char* buf = (char*)realloc(_buf, size + 1);
+        if (!buf)
+            return false;
+        _buf = buf;
+        _cap = size;
+        return true;
+    }
+
+    String& assign(const char* str, size_t n)
+    {
+        _len = 0;
+        if (reserve(n)) {
+            memcpy(_buf, str, n);
+            _len = n;
+            _buf[_len] = 0;
+        }
+        return *this;
+    }
+
+    template <typename T>
+    void assign_number(const char* format, T value)
+    {
+        char buf[24];
+        int n = snprintf(buf, sizeof(buf), format, value);
+        assign(buf, n);
+    }
+};
+
+inline String operator+(const String& lhs, const String& rhs)
+{
+    String result(lhs);
+    result += rhs;
+    return result;
+}
+
+inline String operator+(const String& lhs, const char* rhs)
+{
+    String result(lhs);
+    result += rhs;
+    return result;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Minimal Stream so ArduinoJson can deserialize straight from a File.
+ */
+class Stream {
+public:
+    virtual ~Stream() { }
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual size_t readBytes(char* buffer, size_t length)
+    {
+        size_t n = 0;
+        int c;
+        while (n < length && (c = read()) >= 0)
+            buffer[n++] = (char)c;
+        return n;
+    }
+};
+
+#endif
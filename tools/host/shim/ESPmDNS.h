@@ -0,0 +1,26 @@
+
+#ifndef host_shim_esp_mdns_h
+#define host_shim_esp_mdns_h
+
+/**
+ * Host stand-in for ESPmDNS. Queries never find a clashing host.
+ */
+
+#include "Arduino.h"
+
+typedef struct {
+    uint32_t addr;
+} esp_ip4_addr_t;
+
+inline esp_err_t mdns_init() { return ESP_OK; }
+inline void mdns_free() { }
+inline esp_err_t mdns_query_a(const char*, uint32_t, esp_ip4_addr_t*) { return ESP_ERR_NOT_FOUND; }
+
+class MDNSResponder {
+public:
+    bool begin(const char*) { return true; }
+};
+
+inline MDNSResponder MDNS;
+
+#endif
@@ -0,0 +1,99 @@
+
+#ifndef host_shim_fs_h
+#define host_shim_fs_h
+
+/**
+ * Host stand-in for the ESP32 FS API backed by a directory on disk.
+ */
+
+#include "Arduino.h"
+#include <memory>
+#include <string>
+#include <sys/stat.h>
+
+namespace fs {
+
+class File : public Stream {
+    std::shared_ptr<FILE> _file;
+    bool _is_directory = false;
+
+public:
+    File() { }
+    File(FILE* file, bool is_directory)
+        : _file(file, [](FILE* f) { if (f) fclose(f); })
+        , _is_directory(is_directory)
+    { }
+
+    explicit operator bool() const { return _file || _is_directory; }
+    bool isDirectory() const { return _is_directory; }
+    void close() { _file.reset(); }
+
+    size_t size() const
+    {
+        if (!_file)
+            return 0;
+        struct stat st;
+        return fstat(fileno(_file.get()), &st) ? 0 : st.st_size;
+    }
+
+    int available() override
+    {
+        if (!_file)
+            return 0;
+        long pos = ftell(_file.get());
+        return pos < 0 ? 0 : int(size() - pos);
+    }
+
+    int read() override { return _file ? fgetc(_file.get()) : -1; }
+
+    size_t readBytes(char* buffer, size_t length) override
+    {
+        return _file ? fread(buffer, 1, length, _file.get()) : 0;
+    }
+
+    size_t print(const String& str)
+    {
+        return _file ? fwrite(str.c_str(), 1, str.length(), _file.get()) : 0;
+    }
+};
+
+class FS {
+    std::string _root;
+
+public:
+    explicit FS(const std::string& root)
+        : _root(root)
+    { }
+
+    File open(const char* path, const char* mode = "r")
+    {
+        if (!valid(path))
+            return File();
+        std::string full = _root + path;
+        struct stat st;
+        if (!stat(full.c_str(), &st) && S_ISDIR(st.st_mode))
+            return File(nullptr, true);
+        FILE* file = fopen(full.c_str(), mode[0] == 'w' ? "wb" : "rb");
+        return file ? File(file, false) : File();
+    }
+
+    File open(const String& path, const char* mode = "r") { return open(path.c_str(), mode); }
+
+    bool exists(const char* path) { return (bool)open(path); }
+
+    bool rename(const char* from, const char* to)
+    {
+        return valid(from) && valid(to) && !::rename((_root + from).c_str(), (_root + to).c_str());
+    }
+
+    bool remove(const char* path) { return valid(path) && !::remove((_root + path).c_str()); }
+
+private:
+    static bool valid(const char* path) { return path && path[0] == '/' && !strstr(path, ".."); }
+};
+
+} // namespace fs
+
+using fs::File;
+
+#endif
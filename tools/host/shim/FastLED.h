@@ -0,0 +1,139 @@
+
+#ifndef host_shim_fastled_h
+#define host_shim_fastled_h
+
+/**
+ * Host stand-in for the parts of FastLED used by the LED ring. Colour math
+ * is simplified; show() blocks for as long as the device takes to clock
+ * out its pixels so control loop timing stays comparable.
+ */
+
+#include "Arduino.h"
+
+#define FASTLED_USING_NAMESPACE
+
+enum EOrder { GRB };
+enum ESPIChipsets { WS2811 };
+enum LEDColorCorrection { TypicalLEDStrip };
+
+inline uint8_t qadd8(uint8_t i, uint8_t j) { return i + j > 255 ? 255 : i + j; }
+inline uint8_t qsub8(uint8_t i, uint8_t j) { return i > j ? i - j : 0; }
+inline uint8_t scale8(uint8_t i, uint8_t scale) { return (uint16_t(i) * (1 + scale)) >> 8; }
+inline uint8_t random8() { return rand() & 0xFF; }
+inline uint8_t random8(uint8_t lim) { return lim ? rand() % lim : 0; }
+inline uint8_t random8(uint8_t min, uint8_t lim) { return lim > min ? min + rand() % (lim - min) : min; }
+inline uint16_t random16(uint16_t lim) { return lim ? rand() % lim : 0; }
+
+inline uint8_t beatsin8(uint8_t bpm, uint8_t lowest = 0, uint8_t highest = 255, uint32_t timebase = 0, uint8_t phase_offset = 0)
+{
+    uint8_t beat = ((millis() - timebase) * bpm * 256 / 60000) + phase_offset;
+    uint8_t wave = beat < 128 ? beat * 2 : (255 - beat) * 2;
+    return lowest + scale8(wave, highest - lowest);
+}
+
+struct CHSV {
+    uint8_t h, s, v;
+    CHSV(uint8_t hue, uint8_t sat, uint8_t val)
+        : h(hue)
+        , s(sat)
+        , v(val)
+    { }
+};
+
+struct CRGB {
+    uint8_t r = 0, g = 0, b = 0;
+
+    enum HTMLColorCode : uint32_t {
+        Black = 0x000000,
+        Green = 0x008000,
+        Orange = 0xFFA500,
+        Red = 0xFF0000,
+        Yellow = 0xFFFF00,
+    };
+
+    CRGB() { }
+    CRGB(uint8_t red, uint8_t green, uint8_t blue)
+        : r(red)
+        , g(green)
+        , b(blue)
+    { }
+    CRGB(uint32_t code)
+        : r(code >> 16)
+        , g(code >> 8)
+        , b(code)
+    { }
+    CRGB(HTMLColorCode code)
+        : CRGB(uint32_t(code))
+    { }
+
+    CRGB& operator+=(const CHSV& hsv)
+    {
+        r = qadd8(r, hsv.v);
+        g = qadd8(g, hsv.v);
+        b = qadd8(b, hsv.v);
+        return *this;
+    }
+
+    CRGB& nscale8(uint8_t scale)
+    {
+        r = scale8(r, scale);
+        g = scale8(g, scale);
+        b = scale8(b, scale);
+        return *this;
+    }
+};
+
+struct CRGBPalette16 {
+    CRGB entries[4];
+    CRGBPalette16() { }
+    CRGBPalette16(const CRGB& c1, const CRGB& c2, const CRGB& c3, const CRGB& c4)
+        : entries { c1, c2, c3, c4 }
+    { }
+};
+
+inline CRGB ColorFromPalette(const CRGBPalette16& pal, uint8_t index) { return pal.entries[index >> 6]; }
+
+inline void fill_solid(CRGB* leds, int num, const CRGB& color)
+{
+    for (int i = 0; i < num; ++i)
+        leds[i] = color;
+}
+
+inline void fadeToBlackBy(CRGB* leds, uint16_t num, uint8_t fade)
+{
+    for (uint16_t i = 0; i < num; ++i)
+        leds[i].nscale8(255 - fade);
+}
+
+class CLEDController {
+public:
+    CLEDController& setCorrection(LEDColorCorrection) { return *this; }
+};
+
+class CFastLED {
+    CLEDController _controller;
+    int _num_leds = 0;
+    uint8_t _brightness = 255;
+
+public:
+    template <ESPIChipsets CHIPSET, uint8_t DATA_PIN, EOrder RGB_ORDER>
+    CLEDController& addLeds(CRGB*, int num_leds)
+    {
+        _num_leds += num_leds;
+        return _controller;
+    }
+
+    void setBrightness(uint8_t brightness) { _brightness = brightness; }
+    uint8_t getBrightness() const { return _brightness; }
+
+    // WS2811 pixels take 30 us each to clock out
+    void show() { std::this_thread::sleep_for(std::chrono::microseconds(_num_leds * 30)); }
+};
+
+inline CFastLED FastLED;
+
+#define EVERY_N_MILLISECONDS(N)                                    \
+    for (static uint32_t _every_last_ms = 0;                       \
+         millis() - _every_last_ms >= (N) && ((_every_last_ms = millis()), true);)
+
+#endif
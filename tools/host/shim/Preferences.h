@@ -0,0 +1,63 @@
+
+#ifndef host_shim_preferences_h
+#define host_shim_preferences_h
+
+/**
+ * Host stand-in for the NVS backed Preferences class, held in memory. Like
+ * NVS, the values are shared by every instance opened on a namespace.
+ */
+
+#include "Arduino.h"
+#include <map>
+#include <string>
+#include <vector>
+
+class Preferences {
+    typedef std::map<std::string, std::vector<uint8_t>> Namespace;
+
+    Namespace* _values = nullptr;
+
+public:
+    bool begin(const char* name, bool = false)
+    {
+        static std::map<std::string, Namespace> storage;
+        _values = &storage[name];
+        return true;
+    }
+
+    bool remove(const char* key) { return _values->erase(key); }
+
+    size_t putBytes(const char* key, const void* value, size_t len)
+    {
+        const uint8_t* bytes = (const uint8_t*)value;
+        (*_values)[key].assign(bytes, bytes + len);
+        return len;
+    }
+
+    size_t getBytes(const char* key, void* buf, size_t len)
+    {
+        auto it = _values->find(key);
+        if (it == _values->end() || it->second.size() > len)
+            return 0;
+        memcpy(buf, it->second.data(), it->second.size());
+        return it->second.size();
+    }
+
+    size_t putInt(const char* key, int32_t value) { return putBytes(key, &value, sizeof(value)); }
+    size_t putUInt(const char* key, uint32_t value) { return putBytes(key, &value, sizeof(value)); }
+    size_t putUChar(const char* key, uint8_t value) { return putBytes(key, &value, sizeof(value)); }
+
+    int32_t getInt(const char* key, int32_t value = 0) { return get(key, value); }
+    uint32_t getUInt(const char* key, uint32_t value = 0) { return get(key, value); }
+    uint8_t getUChar(const char* key, uint8_t value = 0) { return get(key, value); }
+
+private:
+    template <typename T>
+    T get(const char* key, T value)
+    {
+        T stored;
+        return getBytes(key, &stored, sizeof(stored)) == sizeof(stored) ? stored : value;
+    }
+};
+
+#endif
@@ -0,0 +1,349 @@
+
+#ifndef host_shim_web_server_h
+#define host_shim_web_server_h
+
+/**
+ * Host stand-in for the ESP32 WebServer built on POSIX sockets, following
+ * the core's handleClient() state machine:
+ *  - one connection at a time, with no new connections accepted until it
+ *    is dropped
+ *  - HC_WAIT_READ: returns at once while the client has sent nothing, and
+ *    drops it after HTTP_MAX_DATA_WAIT
+ *  - once data arrives, reads the whole request, blocking the caller
+ *  - HC_WAIT_CLOSE: after responding, holds the connection until the
+ *    client closes it or HTTP_MAX_CLOSE_WAIT passes
+ */
+
+#include "Arduino.h"
+#include "FS.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <functional>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+enum HTTPMethod {
+    HTTP_ANY,
+    HTTP_GET,
+    HTTP_HEAD,
+    HTTP_POST,
+    HTTP_PUT,
+    HTTP_PATCH,
+    HTTP_DELETE,
+    HTTP_OPTIONS,
+};
+
+class WebServer {
+public:
+    typedef std::function<void(void)> THandlerFunction;
+
+private:
+    // Same timeouts as the ESP32 server
+    static const uint32_t HTTP_MAX_DATA_WAIT = 5000;
+    static const uint32_t HTTP_MAX_CLOSE_WAIT = 2000;
+    static const size_t MAX_REQUEST = 16384;
+
+    enum ClientStatus {
+        HC_NONE,
+        HC_WAIT_READ,
+        HC_WAIT_CLOSE,
+    };
+
+    struct Route {
+        String uri;
+        HTTPMethod method;
+        THandlerFunction handler;
+    };
+
+    int _port;
+    int _listen_fd = -1;
+    int _client_fd = -1;
+    ClientStatus _status = HC_NONE;
+    uint32_t _status_change = 0;
+    std::vector<Route> _routes;
+    THandlerFunction _not_found;
+    String _uri;
+    HTTPMethod _method = HTTP_GET;
+    String _body;
+    String _extra_headers;
+
+public:
+    /**
+     * Set before constructing the server to listen somewhere other than the
+     * port hard coded in the sketch.
+     */
+    static int& port_override()
+    {
+        static int port = 0;
+        return port;
+    }
+
+    explicit WebServer(int port = 80)
+        : _port(port_override() ? port_override() : port)
+    { }
+
+    ~WebServer()
+    {
+        if (_listen_fd >= 0)
+            ::close(_listen_fd);
+    }
+
+    void on(const String& uri, THandlerFunction handler) { on(uri, HTTP_ANY, handler); }
+    void on(const String& uri, HTTPMethod method, THandlerFunction handler) { _routes.push_back({ uri, method, handler }); }
+    void onNotFound(THandlerFunction handler) { _not_found = handler; }
+
+    void begin()
+    {
+        _listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        setsockopt(_listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(_port);
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        if (bind(_listen_fd, (sockaddr*)&addr, sizeof(addr)) < 0 || ::listen(_listen_fd, 16) < 0) {
+            perror("WebServer::begin");
+            exit(1);
+        }
+        fcntl(_listen_fd, F_SETFL, O_NONBLOCK);
+    }
+
+    int port() const { return _port; }
+
+    /**
+     * Requests handled by every server instance, for the host harness.
+     */
+    static uint64_t& request_count()
+    {
+        static uint64_t count = 0;
+        return count;
+    }
+
+    void handleClient()
+    {
+        if (_status == HC_NONE) {
+            _client_fd = accept(_listen_fd, nullptr, nullptr);
+            if (_client_fd < 0)
+                return;
+            int nodelay = 1;
+            setsockopt(_client_fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+            _status = HC_WAIT_READ;
+            _status_change = millis();
+        }
+
+        bool keep_client = false;
+        if (client_connected()) {
+            switch (_status) {
+            case HC_WAIT_READ:
+                if (client_available()) {
+                    if (read_request()) {
+                        ++request_count();
+                        dispatch();
+                        if (client_connected()) {
+                            _status = HC_WAIT_CLOSE;
+                            _status_change = millis();
+                            keep_client = true;
+                        }
+                    }
+                } else if (millis() - _status_change <= HTTP_MAX_DATA_WAIT) {
+                    keep_client = true;
+                }
+                break;
+            case HC_WAIT_CLOSE:
+                keep_client = millis() - _status_change <= HTTP_MAX_CLOSE_WAIT;
+                break;
+            default:
+                break;
+            }
+        }
+
+        if (!keep_client) {
+            ::close(_client_fd);
+            _client_fd = -1;
+            _status = HC_NONE;
+        }
+    }
+
+    String uri() const { return _uri; }
+    HTTPMethod method() const { return _method; }
+
+    String arg(const String& name) const
+    {
+        if (name == "plain")
+            return _body;
+        return String();
+    }
+
+    void sendHeader(const String& name, const String& value, bool first = false)
+    {
+        String header = name + ": " + value + "\r\n";
+        if (first)
+            _extra_headers = header + _extra_headers;
+        else
+            _extra_headers += header;
+    }
+
+    void send(int code, const char* content_type, const String& content)
+    {
+        send_headers(code, content_type, content.length());
+        write_all(content.c_str(), content.length());
+    }
+
+    void send(int code, const String& content_type, const String& content) { send(code, content_type.c_str(), content); }
+
+    size_t streamFile(File& file, const String& content_type)
+    {
+        size_t size = file.size();
+        send_headers(200, content_type.c_str(), size);
+        char buf[1460];
+        size_t sent = 0;
+        while (sent < size) {
+            size_t n = file.readBytes(buf, std::min(sizeof(buf), size - sent));
+            if (!n || !write_all(buf, n))
+                break;
+            sent += n;
+        }
+        return sent;
+    }
+
+private:
+    bool client_available()
+    {
+        char c;
+        return recv(_client_fd, &c, 1, MSG_PEEK | MSG_DONTWAIT) > 0;
+    }
+
+    /**
+     * Like WiFiClient::connected(), true until the peer has closed, even if
+     * it has unread data.
+     */
+    bool client_connected()
+    {
+        char c;
+        ssize_t n = recv(_client_fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+        return n > 0 || (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR));
+    }
+
+    bool read_request()
+    {
+        std::vector<char> data;
+        size_t header_end = 0;
+        size_t content_length = 0;
+        uint32_t start = millis();
+        while (true) {
+            if (header_end && data.size() >= header_end + content_length)
+                break;
+            if (data.size() > MAX_REQUEST || millis() - start > HTTP_MAX_DATA_WAIT)
+                return false;
+
+            pollfd pfd = { _client_fd, POLLIN, 0 };
+            if (poll(&pfd, 1, 10) <= 0)
+                continue;
+            char buf[1024];
+            ssize_t n = recv(_client_fd, buf, sizeof(buf), 0);
+            if (n <= 0)
+                return false;
+            data.insert(data.end(), buf, buf + n);
+
+            if (!header_end) {
+                for (size_t i = 3; i < data.size(); ++i) {
+                    if (data[i - 3] == '\r' && data[i - 2] == '\n' && data[i - 1] == '\r' && data[i] == '\n') {
+                        header_end = i + 1;
+                        break;
+                    }
+                }
+                if (header_end) {
+                    String headers;
+                    headers.concat(data.data(), header_end);
+                    content_length = parse_headers(headers);
+                }
+            }
+        }
+
+        _body = String();
+        _body.concat(data.data() + header_end, content_length);
+        return true;
+    }
+
+    size_t parse_headers(const String& headers)
+    {
+        int method_end = headers.indexOf(' ');
+        int uri_end = headers.indexOf(' ', method_end + 1);
+        if (method_end < 0 || uri_end < 0)
+            return 0;
+        String method = headers.substring(0, method_end);
+        _method = method == "POST" ? HTTP_POST
+            : method == "PUT"      ? HTTP_PUT
+            : method == "DELETE"   ? HTTP_DELETE
+            : method == "HEAD"     ? HTTP_HEAD
+                                   : HTTP_GET;
+        _uri = headers.substring(method_end + 1, uri_end);
+        int query = _uri.indexOf('?');
+        if (query >= 0)
+            _uri = _uri.substring(0, query);
+
+        const char* length = strcasestr(headers.c_str(), "\r\nContent-Length:");
+        return length ? strtoul(length + 17, nullptr, 10) : 0;
+    }
+
+    void dispatch()
+    {
+        for (const Route& route : _routes) {
+            if (route.uri == _uri && (route.method == HTTP_ANY || route.method == _method)) {
+                route.handler();
+                return;
+            }
+        }
+        if (_not_found)
+            _not_found();
+        else
+            send(404, "text/plain", "Not found");
+    }
+
+    void send_headers(int code, const char* content_type, size_t content_length)
+    {
+        char buf[256];
+        snprintf(buf, sizeof(buf),
+            "HTTP/1.1 %d %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\nConnection: close\r\n",
+            code, reason(code), content_type, content_length);
+        String headers(buf);
+        headers += _extra_headers;
+        headers += "\r\n";
+        _extra_headers = String();
+        write_all(headers.c_str(), headers.length());
+    }
+
+    bool write_all(const char* data, size_t len)
+    {
+        while (len) {
+            ssize_t n = ::send(_client_fd, data, len, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                return false;
+            data += n;
+            len -= n;
+        }
+        return true;
+    }
+
+    static const char* reason(int code)
+    {
+        switch (code) {
+        case 200: return "OK";
+        case 308: return "Permanent Redirect";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 500: return "Internal Server Error";
+        default: return "";
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,104 @@
+
+#ifndef host_shim_wifi_h
+#define host_shim_wifi_h
+
+/**
+ * Host stand-in for the ESP32 WiFi class. The host is always connected and
+ * reports the loopback address. Switching to DHCP reports a lease at once.
+ */
+
+#include "Arduino.h"
+#include <functional>
+#include <vector>
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_CONNECTED = 3,
+    WL_DISCONNECTED = 6,
+} wl_status_t;
+
+typedef enum {
+    WIFI_OFF,
+    WIFI_STA,
+} wifi_mode_t;
+
+typedef enum {
+    ARDUINO_EVENT_WIFI_STA_GOT_IP = 7,
+} arduino_event_id_t;
+
+typedef struct {
+} arduino_event_info_t;
+
+class IPAddress {
+    uint8_t _bytes[4] = { 0 };
+
+public:
+    IPAddress() { }
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+        : _bytes { a, b, c, d }
+    { }
+    IPAddress(uint32_t addr) { memcpy(_bytes, &addr, sizeof(_bytes)); }
+
+    operator uint32_t() const
+    {
+        uint32_t addr;
+        memcpy(&addr, _bytes, sizeof(addr));
+        return addr;
+    }
+
+    bool fromString(const char* str)
+    {
+        unsigned a, b, c, d;
+        if (sscanf(str, "%u.%u.%u.%u", &a, &b, &c, &d) != 4)
+            return false;
+        *this = IPAddress(a, b, c, d);
+        return true;
+    }
+
+    String toString() const
+    {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%u.%u.%u.%u", _bytes[0], _bytes[1], _bytes[2], _bytes[3]);
+        return String(buf);
+    }
+};
+
+#ifndef INADDR_NONE
+const IPAddress INADDR_NONE(0, 0, 0, 0);
+#endif
+
+class WiFiClass {
+    typedef std::function<void(arduino_event_id_t, arduino_event_info_t)> EventHandler;
+
+    uint8_t _bssid[6] = { 0 };
+    std::vector<EventHandler> _got_ip_handlers;
+
+public:
+    bool mode(wifi_mode_t) { return true; }
+    wl_status_t begin(const char*, const char*, int32_t = 0, const uint8_t* = nullptr) { return WL_CONNECTED; }
+    bool config(IPAddress local_ip, IPAddress, IPAddress, IPAddress = IPAddress())
+    {
+        if (!uint32_t(local_ip))
+            for (const EventHandler& handler : _got_ip_handlers)
+                handler(ARDUINO_EVENT_WIFI_STA_GOT_IP, arduino_event_info_t());
+        return true;
+    }
+
+    void onEvent(EventHandler handler, arduino_event_id_t)
+    {
+        _got_ip_handlers.push_back(handler);
+    }
+
+    bool disconnect() { return true; }
+    wl_status_t status() { return WL_CONNECTED; }
+    IPAddress localIP() { return IPAddress(127, 0, 0, 1); }
+    IPAddress gatewayIP() { return IPAddress(127, 0, 0, 1); }
+    IPAddress subnetMask() { return IPAddress(255, 0, 0, 0); }
+    IPAddress dnsIP() { return IPAddress(127, 0, 0, 1); }
+    uint8_t* BSSID() { return _bssid; }
+    int32_t channel() { return 1; }
+};
+
+inline WiFiClass WiFi;
+
+#endif
@@ -0,0 +1,99 @@
+
+#ifndef latency_histogram_h
+#define latency_histogram_h
+
+#include <cstdint>
+#include <cstring>
+
+/*---------------------------------------------------------------------------*/
+
+/**
+ * Fixed-size log-linear histogram of microsecond durations. Each power of
+ * two is split into SUB_BUCKETS linear buckets, so percentiles are accurate
+ * to about 6% whether a run lasts a minute or a day, with no per-sample
+ * allocation.
+ */
+class LatencyHistogram {
+    static const int SUB_BITS = 4;
+    static const int SUB_BUCKETS = 1 << SUB_BITS;
+    static const int NUM_BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+    uint64_t _counts[NUM_BUCKETS];
+    uint64_t _total = 0;
+    uint64_t _sum_us = 0;
+    uint64_t _max_us = 0;
+
+public:
+    LatencyHistogram() { reset(); }
+
+    void reset()
+    {
+        memset(_counts, 0, sizeof(_counts));
+        _total = _sum_us = _max_us = 0;
+    }
+
+    void add(uint64_t us)
+    {
+        ++_counts[bucket(us)];
+        ++_total;
+        _sum_us += us;
+        if (us > _max_us)
+            _max_us = us;
+    }
+
+    void merge(const LatencyHistogram& other)
+    {
+        for (int i = 0; i < NUM_BUCKETS; ++i)
+            _counts[i] += other._counts[i];
+        _total += other._total;
+        _sum_us += other._sum_us;
+        if (other._max_us > _max_us)
+            _max_us = other._max_us;
+    }
+
+    uint64_t count() const { return _total; }
+    uint64_t max_us() const { return _max_us; }
+    uint64_t mean_us() const { return _total ? _sum_us / _total : 0; }
+
+    /**
+     * Upper bound of the bucket holding the given percentile (0-100).
+     */
+    uint64_t percentile_us(double pct) const
+    {
+        if (!_total)
+            return 0;
+        uint64_t rank = uint64_t(pct / 100.0 * _total + 0.5);
+        if (rank < 1)
+            rank = 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < NUM_BUCKETS; ++i) {
+            seen += _counts[i];
+            if (seen >= rank)
+                return upper_bound(i) < _max_us ? upper_bound(i) : _max_us;
+        }
+        return _max_us;
+    }
+
+private:
+    static int bucket(uint64_t us)
+    {
+        if (us < SUB_BUCKETS)
+            return int(us);
+        int msb = 63 - __builtin_clzll(us);
+        int shift = msb - SUB_BITS;
+        return (shift + 1) * SUB_BUCKETS + int((us >> shift) & (SUB_BUCKETS - 1));
+    }
+
+    static uint64_t upper_bound(int index)
+    {
+        if (index < SUB_BUCKETS)
+            return index;
+        int shift = index / SUB_BUCKETS - 1;
+        uint64_t base = uint64_t(SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+        return base + (uint64_t(1) << shift) - 1;
+    }
+};
+
+/*---------------------------------------------------------------------------*/
+
+#endif
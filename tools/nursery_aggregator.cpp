@@ -0,0 +1,266 @@
+
+/**
+ * Host tool that listens for NurseryServer state frames on the multicast
+ * group and prints a merged view of every unit.
+ *
+ * Usage:
+ *   nursery_aggregator [--interface ADDR] [--frames N] [--expect HOSTNAME]
+ *                      [--timeout SECS]
+ *   nursery_aggregator --simulate HOSTNAME [--interface ADDR] [--frames N]
+ *
+ * --interface selects the local address used to join or send, e.g. 127.0.0.1
+ * to try it out on loopback. --frames exits after N frames have been received
+ * or sent. --simulate publishes synthetic frames like a unit would.
+ *
+ * For testing, --expect makes the listener count only frames from HOSTNAME
+ * and exit with an error unless each one decodes to exactly what --simulate
+ * sent for that sequence number. --timeout fails the listener if no frame
+ * arrives for SECS seconds.
+ */
+
+#include "../NurseryServer/state_frame.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+/*---------------------------------------------------------------------------*/
+
+namespace {
+
+const int STALE_SECS = 15; // Three missed heartbeats
+
+const char* RING_MODES[] = { "off", "pulse", "confetti", "candle", "timeout" };
+
+struct Node {
+    std::string address;
+    StateFrame frame;
+    uint32_t frames = 0;
+    uint32_t lost = 0;
+    std::chrono::steady_clock::time_point last_seen;
+};
+
+struct Options {
+    const char* interface = nullptr;
+    const char* simulate = nullptr;
+    const char* expect = nullptr;
+    long frames = 0;
+    long timeout_secs = 0;
+};
+
+bool parse_args(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        bool has_value = i + 1 < argc;
+        if (!strcmp(argv[i], "--interface") && has_value)
+            options.interface = argv[++i];
+        else if (!strcmp(argv[i], "--simulate") && has_value)
+            options.simulate = argv[++i];
+        else if (!strcmp(argv[i], "--frames") && has_value)
+            options.frames = atol(argv[++i]);
+        else if (!strcmp(argv[i], "--expect") && has_value)
+            options.expect = argv[++i];
+        else if (!strcmp(argv[i], "--timeout") && has_value)
+            options.timeout_secs = atol(argv[++i]);
+        else
+            return false;
+    }
+    return true;
+}
+
+in_addr interface_address(const Options& options)
+{
+    in_addr addr;
+    addr.s_addr = htonl(INADDR_ANY);
+    if (options.interface)
+        inet_pton(AF_INET, options.interface, &addr);
+    return addr;
+}
+
+/**
+ * The frame --simulate sends with the given sequence number. Varies every
+ * field, including negative temperatures, so a round trip checks them all.
+ */
+StateFrame simulated_frame(const char* hostname, uint32_t sequence)
+{
+    StateFrame frame;
+    frame.set_hostname(hostname);
+    frame.sequence = sequence;
+    frame.brightness = (sequence * 10) % 250;
+    frame.ring_mode = (sequence / 5) % 4;
+    frame.flags = (sequence % 3 == 0 ? StateFrame::FLAG_MOTION : 0) | StateFrame::FLAG_DOOR_CLOSED;
+    frame.temperature_tenths_f = sequence % 2 ? 712 : -35;
+    frame.humidity = 40 + sequence % 20;
+    frame.timeout_secs = sequence * 7;
+    return frame;
+}
+
+bool same_state(const StateFrame& a, const StateFrame& b)
+{
+    return a.flags == b.flags
+        && a.sequence == b.sequence
+        && a.brightness == b.brightness
+        && a.ring_mode == b.ring_mode
+        && a.temperature_tenths_f == b.temperature_tenths_f
+        && a.humidity == b.humidity
+        && a.timeout_secs == b.timeout_secs
+        && !strcmp(a.hostname, b.hostname);
+}
+
+void print_nodes(const std::map<std::string, Node>& nodes)
+{
+    auto now = std::chrono::steady_clock::now();
+    if (isatty(STDOUT_FILENO))
+        printf("\033[H\033[2J");
+    printf("%-20s %-16s %5s %-9s %-6s %-6s %7s %4s %7s %6s %5s\n",
+        "HOST", "ADDRESS", "LEVEL", "RING", "DOOR", "MOTION", "TEMP F", "RH", "TIMEOUT", "FRAMES", "LOST");
+    for (const auto& entry : nodes) {
+        const Node& node = entry.second;
+        const StateFrame& f = node.frame;
+        long age = std::chrono::duration_cast<std::chrono::seconds>(now - node.last_seen).count();
+        const char* ring = f.ring_mode < sizeof(RING_MODES) / sizeof(RING_MODES[0]) ? RING_MODES[f.ring_mode] : "?";
+        printf("%-20s %-16s %5d %-9s %-6s %-6s %7.1f %3d%% %6ds %6u %5u%s\n",
+            f.hostname, node.address.c_str(), f.brightness, ring,
+            f.flags & StateFrame::FLAG_DOOR_CLOSED ? "closed" : "open",
+            f.flags & StateFrame::FLAG_MOTION ? "yes" : "no",
+            f.temperature_tenths_f / 10.0, f.humidity, f.timeout_secs,
+            node.frames, node.lost, age > STALE_SECS ? "  (stale)" : "");
+    }
+    fflush(stdout);
+}
+
+int run_listener(int sock, const Options& options)
+{
+    int reuse = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in local = {};
+    local.sin_family = AF_INET;
+    local.sin_port = htons(StateFrame::PORT);
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(sock, (sockaddr*)&local, sizeof(local)) < 0) {
+        perror("bind");
+        return 1;
+    }
+
+    ip_mreq mreq = {};
+    inet_pton(AF_INET, StateFrame::GROUP, &mreq.imr_multiaddr);
+    mreq.imr_interface = interface_address(options);
+    if (setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+        perror("IP_ADD_MEMBERSHIP");
+        return 1;
+    }
+
+    // Without --timeout, wake up every second to redraw so silent units are
+    // shown as stale even when nothing else is sending
+    timeval timeout = { options.timeout_secs ? options.timeout_secs : 1, 0 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    // Keyed by host and address so two units that fell back to the same name stay distinct
+    std::map<std::string, Node> nodes;
+    long received = 0;
+    while (!options.frames || received < options.frames) {
+        uint8_t buf[512];
+        sockaddr_in from = {};
+        socklen_t from_len = sizeof(from);
+        ssize_t len = recvfrom(sock, buf, sizeof(buf), 0, (sockaddr*)&from, &from_len);
+        if (len < 0) {
+            bool timed_out = errno == EAGAIN || errno == EWOULDBLOCK;
+            if (timed_out && !options.timeout_secs) {
+                if (!nodes.empty())
+                    print_nodes(nodes);
+                continue;
+            }
+            if (timed_out)
+                fprintf(stderr, "Timed out after %ld of %ld frames\n", received, options.frames);
+            else
+                perror("recvfrom");
+            return 1;
+        }
+
+        StateFrame frame;
+        if (!frame.decode(buf, len))
+            continue;
+        if (options.expect) {
+            if (strcmp(frame.hostname, options.expect))
+                continue;
+            if (!same_state(frame, simulated_frame(options.expect, frame.sequence))) {
+                fprintf(stderr, "Frame %u does not match what was sent\n", frame.sequence);
+                return 1;
+            }
+        }
+        ++received;
+
+        char address[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &from.sin_addr, address, sizeof(address));
+        Node& node = nodes[std::string(frame.hostname) + "@" + address];
+        if (node.frames && frame.sequence > node.frame.sequence + 1)
+            node.lost += frame.sequence - node.frame.sequence - 1;
+        node.address = address;
+        node.frame = frame;
+        node.last_seen = std::chrono::steady_clock::now();
+        ++node.frames;
+
+        print_nodes(nodes);
+    }
+    return 0;
+}
+
+int run_simulator(int sock, const Options& options)
+{
+    in_addr interface = interface_address(options);
+    setsockopt(sock, IPPROTO_IP, IP_MULTICAST_IF, &interface, sizeof(interface));
+    int loop = 1;
+    setsockopt(sock, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+
+    sockaddr_in group = {};
+    group.sin_family = AF_INET;
+    group.sin_port = htons(StateFrame::PORT);
+    inet_pton(AF_INET, StateFrame::GROUP, &group.sin_addr);
+
+    for (long sent = 0; !options.frames || sent < options.frames; ++sent) {
+        StateFrame frame = simulated_frame(options.simulate, sent + 1);
+        uint8_t buf[StateFrame::MAX_SIZE];
+        size_t len = frame.encode(buf, sizeof(buf));
+        if (sendto(sock, buf, len, 0, (sockaddr*)&group, sizeof(group)) < 0) {
+            perror("sendto");
+            return 1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+    return 0;
+}
+
+} // namespace
+
+/*---------------------------------------------------------------------------*/
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parse_args(argc, argv, options)) {
+        fprintf(stderr,
+            "usage: %s [--simulate HOSTNAME] [--interface ADDR] [--frames N]\n"
+            "          [--expect HOSTNAME] [--timeout SECS]\n",
+            argv[0]);
+        return 2;
+    }
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) {
+        perror("socket");
+        return 1;
+    }
+
+    int result = options.simulate ? run_simulator(sock, options) : run_listener(sock, options);
+    close(sock);
+    return result;
+}
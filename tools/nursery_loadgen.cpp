@@ -0,0 +1,293 @@
+
+/**
+ * HTTP load generator for NurseryServer, aimed at a unit or at
+ * nursery_host_server. Each client thread repeatedly picks a request class
+ * by weight and reports throughput and latency percentiles per class.
+ *
+ * Request classes:
+ *   static   - one of the status page assets
+ *   status   - GET /status, as the status page and dashboards poll it
+ *   command  - a burst of --burst back-to-back light and ring commands,
+ *              the last of which is /off
+ *
+ * Usage:
+ *   nursery_loadgen [--host ADDR] [--port N] [--clients N] [--duration SECS]
+ *                   [--mix static=W,status=W,command=W] [--burst N]
+ *                   [--think-ms MS] [--report SECS]
+ *
+ * A --duration of 0 runs until interrupted, for soak tests.
+ */
+
+#include "latency_histogram.h"
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <random>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/*---------------------------------------------------------------------------*/
+
+namespace {
+
+enum RequestClass {
+    STATIC,
+    STATUS,
+    COMMAND,
+    NUM_CLASSES,
+};
+
+const char* CLASS_NAMES[NUM_CLASSES] = { "static", "status", "command" };
+const char* STATIC_PATHS[] = { "/index.html", "/app.js", "/style.css" };
+// Cycled through from the start of each burst, which always ends with /off
+// so it leaves the lights in a known state
+const char* COMMAND_PATHS[] = { "/brighter", "/dimmer", "/timeout", "/timeout" };
+const int NUM_COMMAND_PATHS = sizeof(COMMAND_PATHS) / sizeof(COMMAND_PATHS[0]);
+
+struct Options {
+    const char* host = "127.0.0.1";
+    int port = 80;
+    int clients = 4;
+    uint32_t duration_secs = 60;
+    uint32_t weights[NUM_CLASSES] = { 20, 70, 10 };
+    int burst = 5;
+    uint32_t think_ms = 0;
+    uint32_t report_secs = 10;
+};
+
+struct Stats {
+    LatencyHistogram latency[NUM_CLASSES];
+    uint64_t errors[NUM_CLASSES] = { 0 };
+};
+
+std::mutex stats_mutex;
+Stats interval_stats;
+Stats total_stats;
+std::atomic<bool> stop_requested(false);
+volatile sig_atomic_t interrupted = 0;
+
+bool parse_mix(const char* mix, Options& options)
+{
+    uint32_t weights[NUM_CLASSES] = { 0 };
+    char buf[128];
+    snprintf(buf, sizeof(buf), "%s", mix);
+    for (char* item = strtok(buf, ","); item; item = strtok(nullptr, ",")) {
+        char* eq = strchr(item, '=');
+        if (!eq)
+            return false;
+        *eq = 0;
+        int cls = -1;
+        for (int i = 0; i < NUM_CLASSES; ++i)
+            if (!strcmp(item, CLASS_NAMES[i]))
+                cls = i;
+        if (cls < 0)
+            return false;
+        weights[cls] = atoi(eq + 1);
+    }
+    memcpy(options.weights, weights, sizeof(weights));
+    return weights[STATIC] + weights[STATUS] + weights[COMMAND] > 0;
+}
+
+bool parse_args(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        bool has_value = i + 1 < argc;
+        if (!strcmp(argv[i], "--host") && has_value)
+            options.host = argv[++i];
+        else if (!strcmp(argv[i], "--port") && has_value)
+            options.port = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--clients") && has_value)
+            options.clients = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--duration") && has_value)
+            options.duration_secs = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--mix") && has_value) {
+            if (!parse_mix(argv[++i], options))
+                return false;
+        } else if (!strcmp(argv[i], "--burst") && has_value)
+            options.burst = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--think-ms") && has_value)
+            options.think_ms = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--report") && has_value)
+            options.report_secs = atoi(argv[++i]);
+        else
+            return false;
+    }
+    return options.clients > 0 && options.burst > 0 && options.report_secs > 0;
+}
+
+/**
+ * Issues one GET on a fresh connection, reads the response up to its
+ * Content-Length and closes, as a browser does; the ESP32 server holds the
+ * connection until the client closes it. Returns false on any connection
+ * error, short response or non-2xx/3xx status.
+ */
+bool http_get(const sockaddr_in& addr, const char* path)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+        return false;
+    timeval timeout = { 10, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    int nodelay = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+    bool ok = false;
+    if (!connect(fd, (const sockaddr*)&addr, sizeof(addr))) {
+        char request[256];
+        int len = snprintf(request, sizeof(request), "GET %s HTTP/1.1\r\nHost: nursery\r\nConnection: close\r\n\r\n", path);
+        if (send(fd, request, len, MSG_NOSIGNAL) == len) {
+            std::string headers;
+            size_t header_end = std::string::npos;
+            size_t body = 0;
+            bool complete = false;
+            char buf[4096];
+            ssize_t n;
+            while (!complete && (n = recv(fd, buf, sizeof(buf), 0)) > 0) {
+                if (header_end == std::string::npos) {
+                    headers.append(buf, n);
+                    header_end = headers.find("\r\n\r\n");
+                    if (header_end == std::string::npos)
+                        continue;
+                    body = headers.size() - header_end - 4;
+                    headers.resize(header_end + 2);
+                } else {
+                    body += n;
+                }
+                const char* length = strcasestr(headers.c_str(), "\r\nContent-Length:");
+                complete = length && body >= strtoul(length + 17, nullptr, 10);
+            }
+            // Without a Content-Length the body runs until the server closes
+            if (!complete && n == 0 && header_end != std::string::npos)
+                complete = !strcasestr(headers.c_str(), "\r\nContent-Length:");
+
+            int code = 0;
+            ok = complete && sscanf(headers.c_str(), "HTTP/1.%*d %d", &code) == 1 && code >= 200 && code < 400;
+        }
+    }
+    close(fd);
+    return ok;
+}
+
+void client(const Options& options, const sockaddr_in& addr, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    uint32_t total_weight = options.weights[STATIC] + options.weights[STATUS] + options.weights[COMMAND];
+
+    while (!stop_requested) {
+        uint32_t pick = rng() % total_weight;
+        RequestClass cls = pick < options.weights[STATIC]                           ? STATIC
+            : pick < options.weights[STATIC] + options.weights[STATUS]              ? STATUS
+                                                                                    : COMMAND;
+        int count = cls == COMMAND ? options.burst : 1;
+        // Bursts run to completion, even when stopping, so they always reach /off
+        for (int i = 0; i < count; ++i) {
+            const char* path = cls == STATIC ? STATIC_PATHS[rng() % 3]
+                : cls == STATUS              ? "/status"
+                : i == count - 1             ? "/off"
+                                             : COMMAND_PATHS[i % NUM_COMMAND_PATHS];
+            auto start = std::chrono::steady_clock::now();
+            bool ok = http_get(addr, path);
+            uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            if (ok) {
+                interval_stats.latency[cls].add(us);
+                total_stats.latency[cls].add(us);
+            } else {
+                ++interval_stats.errors[cls];
+                ++total_stats.errors[cls];
+            }
+        }
+        if (options.think_ms)
+            std::this_thread::sleep_for(std::chrono::milliseconds(options.think_ms));
+    }
+}
+
+void report(const char* label, const Stats& stats, double secs)
+{
+    LatencyHistogram all;
+    uint64_t errors = 0;
+    for (int i = 0; i < NUM_CLASSES; ++i) {
+        all.merge(stats.latency[i]);
+        errors += stats.errors[i];
+    }
+    printf("%s %.0fs: %.1f req/s, %llu ok, %llu errors\n", label, secs, all.count() / secs,
+        (unsigned long long)all.count(), (unsigned long long)errors);
+    for (int i = 0; i <= NUM_CLASSES; ++i) {
+        const LatencyHistogram& h = i < NUM_CLASSES ? stats.latency[i] : all;
+        if (!h.count())
+            continue;
+        printf("  %-8s n=%-8llu p50=%.2fms p99=%.2fms max=%.2fms errors=%llu\n",
+            i < NUM_CLASSES ? CLASS_NAMES[i] : "all", (unsigned long long)h.count(),
+            h.percentile_us(50) / 1000.0, h.percentile_us(99) / 1000.0, h.max_us() / 1000.0,
+            (unsigned long long)(i < NUM_CLASSES ? stats.errors[i] : errors));
+    }
+    fflush(stdout);
+}
+
+} // namespace
+
+/*---------------------------------------------------------------------------*/
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parse_args(argc, argv, options)) {
+        fprintf(stderr,
+            "usage: %s [--host ADDR] [--port N] [--clients N] [--duration SECS]\n"
+            "          [--mix static=W,status=W,command=W] [--burst N] [--think-ms MS] [--report SECS]\n",
+            argv[0]);
+        return 2;
+    }
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(options.port);
+    if (inet_pton(AF_INET, options.host, &addr.sin_addr) != 1) {
+        fprintf(stderr, "Invalid address %s\n", options.host);
+        return 2;
+    }
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < options.clients; ++i)
+        threads.emplace_back(client, std::cref(options), std::cref(addr), 1234 + i);
+
+    signal(SIGINT, [](int) { interrupted = 1; });
+    signal(SIGTERM, [](int) { interrupted = 1; });
+
+    auto start = std::chrono::steady_clock::now();
+    auto last_report = start;
+    while (!interrupted) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - start).count();
+        if (options.duration_secs && elapsed >= options.duration_secs)
+            break;
+        double since_report = std::chrono::duration<double>(now - last_report).count();
+        if (since_report >= options.report_secs) {
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            char label[32];
+            snprintf(label, sizeof(label), "t=%.0fs", elapsed);
+            report(label, interval_stats, since_report);
+            interval_stats = Stats();
+            last_report = now;
+        }
+    }
+
+    stop_requested = true;
+    for (std::thread& t : threads)
+        t.join();
+    report("total", total_stats, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    return 0;
+}